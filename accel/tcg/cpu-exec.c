@@ -28,6 +28,7 @@
 #include "tcg/tcg.h"
 #include "qemu/atomic.h"
 #include "qemu/rcu.h"
+#include "qemu/bitmap.h"
 #include "exec/log.h"
 #include "qemu/main-loop.h"
 #include "sysemu/cpus.h"
@@ -42,6 +43,9 @@
 #include "internal-common.h"
 #include "internal-target.h"
 
+#define SymExpr void*
+#include "RuntimeCommon.h"
+
 /* -icount align implementation. */
 
 typedef struct SyncClocks {
@@ -176,6 +180,117 @@ uint32_t curr_cflags(CPUState *cpu)
     return cflags;
 }
 
+/*
+ * SymQEMU dual translation.
+ *
+ * With sym-dual-tb, a guest block may be translated twice: once with the
+ * symbolic instrumentation and once as a concrete clone (CF_SYM_CONCRETE)
+ * that only keeps the shadow-memory updates of stores. The clone computes
+ * exactly the same expressions as long as no symbolic data flows into it,
+ * i.e., all register expressions are NULL and the CPU state doesn't hold
+ * symbolic bytes; it preserves that property, so clones may chain to each
+ * other. Symbolic guest memory is detected by the clone itself, which then
+ * restarts the instruction in the instrumented variant.
+ */
+#define SYM_ENV_RESCAN_INTERVAL 1024
+
+/* The CPU state is tracked in words of this many bytes. */
+#define SYM_ENV_WORD_SIZE 8
+#define SYM_ENV_WORDS DIV_ROUND_UP(sizeof(CPUArchState), SYM_ENV_WORD_SIZE)
+
+static unsigned long *sym_env_words(CPUState *cpu)
+{
+    if (cpu->sym_env_words == NULL) {
+        cpu->sym_env_words = bitmap_new(SYM_ENV_WORDS);
+    }
+    return cpu->sym_env_words;
+}
+
+void sym_env_mark_symbolic(CPUState *cpu, const void *host, uint64_t length)
+{
+    uintptr_t env = (uintptr_t)cpu_env(cpu);
+    uintptr_t addr = (uintptr_t)host;
+
+    /* Other host memory (e.g. the vector scratch slots) is not guest state. */
+    if (length == 0 || addr < env || addr - env >= sizeof(CPUArchState)) {
+        return;
+    }
+    length = MIN(length, sizeof(CPUArchState) - (addr - env));
+    bitmap_set(sym_env_words(cpu), (addr - env) / SYM_ENV_WORD_SIZE,
+               (addr - env + length - 1) / SYM_ENV_WORD_SIZE -
+               (addr - env) / SYM_ENV_WORD_SIZE + 1);
+    cpu->sym_env_dirty = true;
+}
+
+/*
+ * Check the words of the CPU state that host stores made symbolic, one byte
+ * at a time, and forget about the ones that have become concrete again.
+ */
+static bool sym_env_words_concrete(CPUState *cpu)
+{
+    unsigned long *words = sym_env_words(cpu);
+    uint8_t *env = (uint8_t *)cpu_env(cpu);
+    unsigned long w;
+
+    for (w = find_first_bit(words, SYM_ENV_WORDS); w < SYM_ENV_WORDS;
+         w = find_next_bit(words, SYM_ENV_WORDS, w + 1)) {
+        size_t start = w * SYM_ENV_WORD_SIZE;
+        size_t end = MIN(start + SYM_ENV_WORD_SIZE, sizeof(CPUArchState));
+
+        for (size_t i = start; i < end; i++) {
+            if (_sym_read_memory(env + i, 1, true) != NULL) {
+                return false;
+            }
+        }
+        clear_bit(w, words);
+    }
+    return true;
+}
+
+static bool sym_state_is_concrete(CPUState *cpu)
+{
+    CPUArchState *env = cpu_env(cpu);
+    void **exprs = env_archcpu(env)->env_exprs;
+    int i, n = tcg_ctx->nb_globals / 2;
+
+    for (i = 0; i < n; i++) {
+        if (exprs[i] != NULL) {
+            return false;
+        }
+    }
+
+    /*
+     * Host stores only mark parts of the CPU state; check every now and then
+     * whether the symbolic bytes there have been overwritten since.
+     */
+    if (cpu->sym_env_dirty) {
+        if (++cpu->sym_env_rescan < SYM_ENV_RESCAN_INTERVAL) {
+            return false;
+        }
+        cpu->sym_env_rescan = 0;
+        if (!sym_env_words_concrete(cpu)) {
+            return false;
+        }
+        cpu->sym_env_dirty = false;
+    }
+    return true;
+}
+
+uint32_t sym_select_variant(CPUState *cpu, uint32_t cflags)
+{
+    if (!qatomic_read(&sym_dual_tb)) {
+        return cflags;
+    }
+    if (cpu->sym_force_instrumented) {
+        cpu->sym_force_instrumented = false;
+        return cflags;
+    }
+    if (sym_state_is_concrete(cpu)) {
+        cflags |= CF_SYM_CONCRETE;
+    }
+    return cflags;
+}
+
 struct tb_desc {
     vaddr pc;
     uint64_t cs_base;
@@ -416,7 +531,7 @@ const void *HELPER(lookup_tb_ptr)(CPUArchState *env)
     cpu->neg.can_do_io = true;
     cpu_get_tb_cpu_state(env, &pc, &cs_base, &flags);
 
-    cflags = curr_cflags(cpu);
+    cflags = sym_select_variant(cpu, curr_cflags(cpu));
     if (check_for_breakpoints(cpu, pc, &cflags)) {
         cpu_loop_exit(cpu);
     }
@@ -979,6 +1094,7 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
             } else {
                 cpu->cflags_next_tb = -1;
             }
+            cflags = sym_select_variant(cpu, cflags);
 
             if (check_for_breakpoints(cpu, pc, &cflags)) {
                 break;
@@ -1014,6 +1130,15 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 last_tb = NULL;
             }
 #endif
+            /*
+             * An instrumented TB may leave symbolic state behind, so it must
+             * not chain directly to a concrete clone.
+             */
+            if (last_tb && !(tb_cflags(last_tb) & CF_SYM_CONCRETE) &&
+                (tb_cflags(tb) & CF_SYM_CONCRETE)) {
+                last_tb = NULL;
+            }
+
             /* See if we can patch the calling TB. */
             if (last_tb) {
                 tb_add_jump(last_tb, tb_exit, tb);
@@ -16,6 +16,8 @@ extern int64_t max_delay;
 extern int64_t max_advance;
 
 extern bool one_insn_per_tb;
+extern bool sym_dual_tb;
+extern uint32_t sym_branch_budget;
 
 /*
  * Return true if CS is not running in parallel with other cpus, either
@@ -115,4 +115,8 @@ static inline vaddr log_pc(CPUState *cpu, const TranslationBlock *tb)
         }                         \
     } while (0)
 
+/* SymQEMU dual translation, see cpu-exec.c. */
+uint32_t sym_select_variant(CPUState *cpu, uint32_t cflags);
+void sym_env_mark_symbolic(CPUState *cpu, const void *host, uint64_t length);
+
 #endif /* ACCEL_TCG_INTERNAL_H */
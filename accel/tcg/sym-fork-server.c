@@ -0,0 +1,440 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AFL-compatible fork server (see include/tcg/sym-fork-server.h)
+ *
+ * The protocol is AFL's: the server announces itself with four bytes on
+ * SYM_FORKSRV_ST_FD, then for every four bytes it reads from SYM_FORKSRV_FD
+ * it forks a child, writes the child's PID to SYM_FORKSRV_ST_FD and, once the
+ * child has exited, its wait status. Without a fuzzer on the other end, the
+ * first write fails and the emulator just carries on.
+ *
+ * All children share SYMCC_OUTPUT_DIR, and the backend of each of them
+ * numbers its test cases from zero again. After every run, the server
+ * therefore moves the files that the run wrote there into a subdirectory of
+ * their own (made unique with a numeric suffix, since inputs in different
+ * directories may have the same name), leaving alone whatever the directory
+ * held before the server started.
+ *
+ * In persistent mode, a child exits as soon as the guest reaches the end
+ * address, skipping whatever the guest would do after it. Every run still
+ * gets a fresh child: the path constraints that the backend collects cannot
+ * be saved or reset through the runtime's interface, so a child that went
+ * back to the start would solve the next run's queries under the previous
+ * run's constraints.
+ *
+ * In batch mode, the server reads the requests from a queue of input files
+ * instead of a fuzzer: before each run, it copies the next input to
+ * SYMCC_INPUT_FILE (or opens it as the child's standard input), and after
+ * it, it prints a summary line. The test cases of the run go to a
+ * subdirectory named after the input, as described below.
+ */
+
+#include "qemu/osdep.h"
+#include "exec/exec-all.h"
+#include "exec/page-protection.h"
+#include "hw/core/cpu.h"
+#include "tcg/tcg.h"
+#include "tcg/sym-fork-server.h"
+#include "qemu.h"
+#include "user-internals.h"
+#include "internal-common.h"
+#include "internal-target.h"
+#include "accel/tcg/tcg-runtime-sym-common.h"
+
+/*
+ * Space left in the code buffer below which the server stops translating
+ * for its children: running out of space in tb_gen_code flushes the buffer
+ * and exits to the CPU loop, which the server must not do.
+ */
+#define SYM_FORK_SERVER_CODE_RESERVE    (4 * MiB)
+
+typedef struct SymForkServerTB {
+    vaddr pc;
+    uint64_t cs_base;
+    uint32_t flags;
+    uint32_t cflags;
+} SymForkServerTB;
+
+/* Batch mode: the queue of inputs and where they and their results go */
+typedef struct SymBatch {
+    GPtrArray *paths;           /* the files of a directory, sorted */
+    guint next;
+    FILE *list;                 /* or a file or FIFO with one path per line */
+    const char *input_file;     /* NULL for standard input */
+} SymBatch;
+
+vaddr sym_fork_server_pc = -1;
+vaddr sym_persistent_end_pc = -1;
+
+/* In a child of the server: where to report new TBs. */
+static int sym_fork_server_tb_fd = -1;
+static bool sym_fork_server_child;
+
+const char *sym_batch_source;
+static SymBatch sym_batch;
+
+/* SYMCC_OUTPUT_DIR, and its files before the first run: name -> mtime */
+static const char *sym_output_dir;
+static GHashTable *sym_output_old_files;
+static char *sym_output_input_name;   /* SYMCC_INPUT_FILE, if it is in there */
+static unsigned int sym_output_runs;
+
+void sym_fork_server_notify_tb(vaddr pc, uint64_t cs_base,
+                               uint32_t flags, uint32_t cflags)
+{
+    SymForkServerTB req = {
+        .pc = pc, .cs_base = cs_base, .flags = flags, .cflags = cflags,
+    };
+
+    /* One-shot TBs (for I/O or exceptions) are not worth keeping. */
+    if (sym_fork_server_tb_fd < 0 || (cflags & CF_COUNT_MASK)) {
+        return;
+    }
+    if (RETRY_ON_EINTR(write(sym_fork_server_tb_fd, &req, sizeof(req))) !=
+        sizeof(req)) {
+        close(sym_fork_server_tb_fd);
+        sym_fork_server_tb_fd = -1;
+    }
+}
+
+void sym_fork_server_fork_end(bool child)
+{
+    /* Only the direct child of the server reports TBs. */
+    if (child && sym_fork_server_tb_fd >= 0) {
+        close(sym_fork_server_tb_fd);
+        sym_fork_server_tb_fd = -1;
+    }
+}
+
+/* Translate the TBs that a child reports on @fd, until it exits. */
+static void sym_fork_server_translate(CPUState *cpu, int fd)
+{
+    SymForkServerTB req;
+
+    while (RETRY_ON_EINTR(read(fd, &req, sizeof(req))) == sizeof(req)) {
+        if ((char *)tcg_ctx->code_gen_highwater -
+            (char *)tcg_ctx->code_gen_ptr < SYM_FORK_SERVER_CODE_RESERVE) {
+            continue;
+        }
+        /* The child may have mapped code that the server doesn't have. */
+        if (!(page_get_flags(req.pc) & PAGE_EXEC)) {
+            continue;
+        }
+
+        mmap_lock();
+        tb_gen_code(cpu, req.pc, req.cs_base, req.flags, req.cflags);
+        mmap_unlock();
+    }
+}
+
+void sym_persistent_end(CPUState *cpu)
+{
+    /* Before the server starts, or without a fuzzer, the guest carries on. */
+    if (!sym_fork_server_child) {
+        return;
+    }
+    preexit_cleanup(cpu_env(cpu), 0);
+    _exit(0);
+}
+
+/* Remember the files that the output directory holds before the first run. */
+static void sym_output_open(const char *prog)
+{
+    g_autoptr(GDir) dir = NULL;
+    const char *input_file = g_getenv("SYMCC_INPUT_FILE");
+    const char *entry;
+
+    sym_output_dir = g_getenv("SYMCC_OUTPUT_DIR");
+    if (sym_output_dir == NULL) {
+        fprintf(stderr, "%s: SYMCC_OUTPUT_DIR is not set\n", prog);
+        exit(EXIT_FAILURE);
+    }
+    if (input_file != NULL) {
+        g_autofree char *input_dir = g_path_get_dirname(input_file);
+        g_autofree char *real_input_dir = realpath(input_dir, NULL);
+        g_autofree char *real_output_dir = realpath(sym_output_dir, NULL);
+
+        if (real_input_dir != NULL && real_output_dir != NULL &&
+            strcmp(real_input_dir, real_output_dir) == 0) {
+            sym_output_input_name = g_path_get_basename(input_file);
+        }
+    }
+
+    sym_output_old_files = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 g_free, g_free);
+    dir = g_dir_open(sym_output_dir, 0, NULL);
+    while (dir != NULL && (entry = g_dir_read_name(dir)) != NULL) {
+        g_autofree char *path = g_build_filename(sym_output_dir, entry, NULL);
+        struct stat st;
+
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            g_hash_table_insert(sym_output_old_files, g_strdup(entry),
+                                g_memdup2(&st.st_mtim, sizeof(st.st_mtim)));
+        }
+    }
+}
+
+/*
+ * Whether the regular file @entry of the output directory is a new one. The
+ * input file may live there too, and it is rewritten before every batch run.
+ */
+static bool sym_output_is_new(const char *entry, const struct stat *st)
+{
+    const struct timespec *mtime =
+        g_hash_table_lookup(sym_output_old_files, entry);
+
+    if (g_strcmp0(entry, sym_output_input_name) == 0) {
+        return false;
+    }
+    return mtime == NULL || mtime->tv_sec != st->st_mtim.tv_sec ||
+           mtime->tv_nsec != st->st_mtim.tv_nsec;
+}
+
+/*
+ * Create a subdirectory of the output directory called @name, or @name.1,
+ * @name.2 and so on if it exists already, and return its path.
+ */
+static char *sym_output_mkdir(const char *name)
+{
+    char *path = g_build_filename(sym_output_dir, name, NULL);
+    unsigned int i = 0;
+
+    while (g_mkdir(path, 0755) < 0) {
+        if (errno != EEXIST) {
+            g_free(path);
+            return NULL;
+        }
+        g_free(path);
+        path = g_strdup_printf("%s/%s.%u", sym_output_dir, name, ++i);
+    }
+    return path;
+}
+
+/* Move the test cases of the last run to a new subdirectory for @name. */
+static unsigned int sym_output_collect(const char *name)
+{
+    g_autoptr(GDir) dir = g_dir_open(sym_output_dir, 0, NULL);
+    g_autofree char *subdir = NULL;
+    const char *entry;
+    unsigned int count = 0;
+
+    while (dir != NULL && (entry = g_dir_read_name(dir)) != NULL) {
+        g_autofree char *from = g_build_filename(sym_output_dir, entry, NULL);
+        g_autofree char *to = NULL;
+        struct stat st;
+
+        if (stat(from, &st) < 0 || !S_ISREG(st.st_mode) ||
+            !sym_output_is_new(entry, &st)) {
+            continue;
+        }
+        if (subdir == NULL && (subdir = sym_output_mkdir(name)) == NULL) {
+            break;
+        }
+        to = g_build_filename(subdir, entry, NULL);
+        if (rename(from, to) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static int sym_batch_compare_paths(gconstpointer a, gconstpointer b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Open the batch queue and set up the shared query counter. */
+static void sym_batch_open(void)
+{
+    struct stat st;
+
+    sym_batch.input_file = g_getenv("SYMCC_INPUT_FILE");
+    sym_output_open("sym-batch");
+
+    if (stat(sym_batch_source, &st) == 0 && S_ISDIR(st.st_mode)) {
+        g_autoptr(GDir) dir = g_dir_open(sym_batch_source, 0, NULL);
+        const char *name;
+
+        sym_batch.paths = g_ptr_array_new_with_free_func(g_free);
+        while (dir != NULL && (name = g_dir_read_name(dir)) != NULL) {
+            g_ptr_array_add(sym_batch.paths,
+                            g_build_filename(sym_batch_source, name, NULL));
+        }
+        g_ptr_array_sort(sym_batch.paths, sym_batch_compare_paths);
+    } else {
+        sym_batch.list = fopen(sym_batch_source, "r");
+    }
+    if (sym_batch.paths == NULL && sym_batch.list == NULL) {
+        perror("sym-batch: open");
+        exit(EXIT_FAILURE);
+    }
+
+    sym_query_counter = mmap(NULL, sizeof(*sym_query_counter),
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sym_query_counter == MAP_FAILED) {
+        perror("sym-batch: mmap");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* The next input of the queue, or NULL at its end. */
+static char *sym_batch_next(void)
+{
+    if (sym_batch.paths != NULL) {
+        return sym_batch.next < sym_batch.paths->len ?
+            g_strdup(g_ptr_array_index(sym_batch.paths, sym_batch.next++)) :
+            NULL;
+    }
+
+    while (true) {
+        g_autofree char *line = NULL;
+        size_t size = 0;
+        ssize_t len = getline(&line, &size, sym_batch.list);
+
+        if (len < 0) {
+            return NULL;
+        }
+        g_strchomp(line);
+        if (*line != '\0') {
+            return g_steal_pointer(&line);
+        }
+    }
+}
+
+/* Make @path the input of the next run, through SYMCC_INPUT_FILE. */
+static bool sym_batch_load(const char *path)
+{
+    g_autoptr(GError) err = NULL;
+    g_autofree char *contents = NULL;
+    gsize len;
+
+    if (!g_file_get_contents(path, &contents, &len, &err) ||
+        (sym_batch.input_file != NULL &&
+         !g_file_set_contents(sym_batch.input_file, contents, len, &err))) {
+        fprintf(stderr, "sym-batch: %s\n", err->message);
+        return false;
+    }
+    return true;
+}
+
+static void sym_batch_report(const char *path, int status, int64_t time_us)
+{
+    g_autofree char *name = g_path_get_basename(path);
+    g_autofree char *result =
+        WIFSIGNALED(status) ? g_strdup_printf("signal:%d", WTERMSIG(status)) :
+        g_strdup_printf("exit:%d", WEXITSTATUS(status));
+
+    fprintf(stderr, "sym-batch: input=%s status=%s time=%.3fms queries=%"
+            PRIu64 " testcases=%u\n", path, result, time_us / 1e3,
+            *sym_query_counter, sym_output_collect(name));
+}
+
+void sym_fork_server_run(CPUState *cpu)
+{
+    g_autofree char *input = NULL;
+    uint32_t msg = 0;
+
+    if (sym_batch_source != NULL) {
+        sym_batch_open();
+    } else if (RETRY_ON_EINTR(write(SYM_FORKSRV_ST_FD, &msg, 4)) != 4) {
+        return;
+    } else {
+        sym_output_open("sym-fork-server");
+    }
+
+    /* Forking needs the CPU outside of its execution section. */
+    cpu_exec_end(cpu);
+    while (true) {
+        int tb_pipe[2], status;
+        int64_t start;
+        pid_t child;
+
+        if (sym_batch_source != NULL) {
+            g_free(input);
+            input = sym_batch_next();
+            if (input == NULL) {
+                exit(EXIT_SUCCESS);
+            }
+            if (!sym_batch_load(input)) {
+                continue;
+            }
+            *sym_query_counter = 0;
+        } else if (RETRY_ON_EINTR(read(SYM_FORKSRV_FD, &msg, 4)) != 4) {
+            exit(EXIT_SUCCESS);
+        }
+        start = g_get_monotonic_time();
+
+        if (pipe(tb_pipe) < 0) {
+            perror("sym-fork-server: pipe");
+            exit(EXIT_FAILURE);
+        }
+
+        fork_start();
+        child = fork();
+        fork_end(child);
+        if (child < 0) {
+            perror("sym-fork-server: fork");
+            exit(EXIT_FAILURE);
+        }
+
+        if (child == 0) {
+            if (sym_batch_source == NULL) {
+                close(SYM_FORKSRV_FD);
+                close(SYM_FORKSRV_ST_FD);
+            } else if (sym_batch.input_file == NULL) {
+                /* The input is read from standard input. */
+                int fd = open(input, O_RDONLY);
+
+                if (fd < 0 || dup2(fd, STDIN_FILENO) < 0) {
+                    perror("sym-batch: open");
+                    exit(EXIT_FAILURE);
+                }
+                close(fd);
+            }
+            close(tb_pipe[0]);
+            qemu_set_cloexec(tb_pipe[1]);
+            sym_fork_server_tb_fd = tb_pipe[1];
+            sym_fork_server_child = true;
+            break;
+        }
+
+        close(tb_pipe[1]);
+        if (sym_batch_source == NULL &&
+            RETRY_ON_EINTR(write(SYM_FORKSRV_ST_FD, &child, 4)) != 4) {
+            exit(EXIT_FAILURE);
+        }
+        sym_fork_server_translate(cpu, tb_pipe[0]);
+        close(tb_pipe[0]);
+        if (RETRY_ON_EINTR(waitpid(child, &status, 0)) < 0) {
+            exit(EXIT_FAILURE);
+        }
+        if (sym_batch_source != NULL) {
+            sym_batch_report(input, status, g_get_monotonic_time() - start);
+        } else {
+            g_autofree char *name =
+                g_strdup_printf("run-%06u", ++sym_output_runs);
+
+            sym_output_collect(name);
+            if (RETRY_ON_EINTR(write(SYM_FORKSRV_ST_FD, &status, 4)) != 4) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    cpu_exec_start(cpu);
+}
@@ -28,6 +28,7 @@
 #include "exec/replay-core.h"
 #include "sysemu/cpu-timers.h"
 #include "tcg/startup.h"
+#include "tcg/tcg.h"
 #include "tcg/oversized-guest.h"
 #include "qapi/error.h"
 #include "qemu/error-report.h"
@@ -47,6 +48,10 @@ struct TCGState {
 
     bool mttcg_enabled;
     bool one_insn_per_tb;
+    bool sym_fast_path;
+    bool sym_fuse;
+    bool sym_dual_tb;
+    uint32_t sym_branch_budget;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -101,6 +106,8 @@ static void tcg_accel_instance_init(Object *obj)
 
 bool mttcg_enabled;
 bool one_insn_per_tb;
+bool sym_dual_tb;
+uint32_t sym_branch_budget;
 
 static int tcg_init_machine(MachineState *ms)
 {
@@ -117,6 +124,8 @@ static int tcg_init_machine(MachineState *ms)
     page_init();
     tb_htable_init();
     tcg_init(s->tb_size * MiB, s->splitwx_enabled, max_cpus, offsetof(ArchCPU, env_exprs) - offsetof(ArchCPU, env));
+    tcg_ctx->sym_fast_path = s->sym_fast_path;
+    tcg_ctx->sym_fuse = s->sym_fuse;
 
 #if defined(CONFIG_SOFTMMU)
     /*
@@ -209,6 +218,68 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_sym_fast_path(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->sym_fast_path;
+}
+
+static void tcg_set_sym_fast_path(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->sym_fast_path = value;
+}
+
+static bool tcg_get_sym_fuse(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->sym_fuse;
+}
+
+static void tcg_set_sym_fuse(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->sym_fuse = value;
+}
+
+static bool tcg_get_sym_dual_tb(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->sym_dual_tb;
+}
+
+static void tcg_set_sym_dual_tb(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->sym_dual_tb = value;
+    qatomic_set(&sym_dual_tb, value);
+}
+
+static void tcg_get_sym_branch_budget(Object *obj, Visitor *v,
+                                      const char *name, void *opaque,
+                                      Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value = s->sym_branch_budget;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_sym_branch_budget(Object *obj, Visitor *v,
+                                      const char *name, void *opaque,
+                                      Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+
+    s->sym_branch_budget = value;
+    qatomic_set(&sym_branch_budget, value);
+}
+
 static int tcg_gdbstub_supported_sstep_flags(void)
 {
     /*
@@ -254,6 +325,30 @@ static void tcg_accel_class_init(ObjectClass *oc, void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "sym-fast-path",
+                                   tcg_get_sym_fast_path,
+                                   tcg_set_sym_fast_path);
+    object_class_property_set_description(oc, "sym-fast-path",
+        "Skip symbolic helper calls inline when all inputs are concrete");
+
+    object_class_property_add_bool(oc, "sym-dual-tb",
+                                   tcg_get_sym_dual_tb,
+                                   tcg_set_sym_dual_tb);
+    object_class_property_set_description(oc, "sym-dual-tb",
+        "Run uninstrumented clones of TBs while no symbolic state is live");
+
+    object_class_property_add_bool(oc, "sym-fuse",
+                                   tcg_get_sym_fuse,
+                                   tcg_set_sym_fuse);
+    object_class_property_set_description(oc, "sym-fuse",
+        "Fuse runs of symbolic helper calls into expression programs");
+
+    object_class_property_add(oc, "sym-branch-budget", "int",
+        tcg_get_sym_branch_budget, tcg_set_sym_branch_budget,
+        NULL, NULL);
+    object_class_property_set_description(oc, "sym-branch-budget",
+        "Queries per branch site before backing off (0: no limit)");
 }
 
 static const TypeInfo tcg_accel_type = {
@@ -7,19 +7,122 @@
 #include "exec/translation-block.h"
 
 #include "accel/tcg/tcg-runtime-sym-common.h"
+#include "internal-common.h"
 
 /* Include the symbolic backend, using void* as expression type. */
 
 #define SymExpr void*
 #include "RuntimeCommon.h"
 
+/*
+ * Cache of recently built constant expressions
+ *
+ * Helpers turn the same small constants (shift distances, masks, concrete
+ * operands) into expressions over and over again. The cache is direct-mapped
+ * and per thread; the expression array is registered with the garbage
+ * collector so that cached expressions stay alive. It is allocated on the
+ * heap and never freed, because the collector keeps a pointer to it.
+ */
+#define SYM_CONST_CACHE_BITS 10
+#define SYM_CONST_CACHE_SIZE (1 << SYM_CONST_CACHE_BITS)
+
+typedef struct SymConstCacheKey {
+    uint64_t value;
+    uint8_t bits;
+} SymConstCacheKey;
+
+static __thread SymConstCacheKey *sym_const_keys;
+static __thread SymExpr *sym_const_exprs;
+
+SymExpr sym_build_constant(uint64_t value, uint8_t bits)
+{
+    uint32_t idx;
+
+    if (unlikely(sym_const_exprs == NULL)) {
+        sym_const_keys = g_new0(SymConstCacheKey, SYM_CONST_CACHE_SIZE);
+        sym_const_exprs = g_new0(SymExpr, SYM_CONST_CACHE_SIZE);
+        _sym_register_expression_region(
+            sym_const_exprs, SYM_CONST_CACHE_SIZE * sizeof(SymExpr));
+    }
+
+    idx = (uint32_t)((value ^ ((uint64_t)bits << 57)) *
+                     0x9e3779b97f4a7c15ull >> (64 - SYM_CONST_CACHE_BITS));
+    if (sym_const_exprs[idx] == NULL ||
+        sym_const_keys[idx].value != value ||
+        sym_const_keys[idx].bits != bits) {
+        sym_const_keys[idx].value = value;
+        sym_const_keys[idx].bits = bits;
+        sym_const_exprs[idx] = _sym_build_integer(value, bits);
+    }
+    return sym_const_exprs[idx];
+}
+
+/*
+ * Symbolic bytes of vector expressions
+ *
+ * Most vector helpers work lane by lane, but typically only a few lanes of a
+ * vector actually hold symbolic data. Producers of vector expressions record
+ * which bytes are symbolic (bit i for byte i, starting at the least
+ * significant byte) so that consumers can skip the other lanes; expressions
+ * that are not found are assumed to be symbolic throughout. The table works
+ * like the constant cache above. Keeping the expressions alive also makes
+ * sure that an entry is never taken for a new expression at the same address.
+ */
+#define SYM_VEC_BYTES_CACHE_BITS 8
+#define SYM_VEC_BYTES_CACHE_SIZE (1 << SYM_VEC_BYTES_CACHE_BITS)
+
+static __thread uint32_t *sym_vec_bytes_masks;
+static __thread SymExpr *sym_vec_bytes_exprs;
+
+static uint32_t sym_vec_bytes_index(SymExpr expr)
+{
+    return (uint32_t)((uintptr_t)expr * 0x9e3779b97f4a7c15ull >>
+                      (64 - SYM_VEC_BYTES_CACHE_BITS));
+}
+
+void sym_vec_set_symbolic_bytes(SymExpr expr, uint32_t mask)
+{
+    uint32_t idx;
+
+    if (expr == NULL) {
+        return;
+    }
+    if (unlikely(sym_vec_bytes_exprs == NULL)) {
+        sym_vec_bytes_masks = g_new0(uint32_t, SYM_VEC_BYTES_CACHE_SIZE);
+        sym_vec_bytes_exprs = g_new0(SymExpr, SYM_VEC_BYTES_CACHE_SIZE);
+        _sym_register_expression_region(
+            sym_vec_bytes_exprs, SYM_VEC_BYTES_CACHE_SIZE * sizeof(SymExpr));
+    }
+
+    idx = sym_vec_bytes_index(expr);
+    sym_vec_bytes_exprs[idx] = expr;
+    sym_vec_bytes_masks[idx] = mask;
+}
+
+uint32_t sym_vec_symbolic_bytes(SymExpr expr, uint64_t length)
+{
+    uint32_t idx;
+
+    g_assert(length <= 32);
+    if (expr == NULL) {
+        return 0;
+    }
+    if (sym_vec_bytes_exprs != NULL) {
+        idx = sym_vec_bytes_index(expr);
+        if (sym_vec_bytes_exprs[idx] == expr) {
+            return sym_vec_bytes_masks[idx];
+        }
+    }
+    return MAKE_64BIT_MASK(0, length);
+}
+
 static SymExpr _sym_build_tsteq(SymExpr a, SymExpr b) {
     size_t bits_a = _sym_bits_helper(a);
     size_t bits_b = _sym_bits_helper(a);
 
     assert(bits_a == bits_b);
 
-    return _sym_build_equal(_sym_build_and(a, b), _sym_build_integer(0, bits_a));
+    return _sym_build_equal(_sym_build_and(a, b), sym_build_constant(0, bits_a));
 }
 
 static SymExpr _sym_build_tstne(SymExpr a, SymExpr b) {
@@ -28,10 +131,150 @@ static SymExpr _sym_build_tstne(SymExpr a, SymExpr b) {
 
     assert(bits_a == bits_b);
 
-    return _sym_build_not_equal(_sym_build_and(a, b), _sym_build_integer(0, bits_a));
+    return _sym_build_not_equal(_sym_build_and(a, b), sym_build_constant(0, bits_a));
 }
 
-void *build_and_push_path_constraint(CPUArchState *env, void *arg1_expr, void *arg2_expr, uint32_t comparison_operator, uint8_t is_taken){
+/*
+ * Per-site query budget for branches
+ *
+ * With sym-branch-budget, comparisons in hot loops (checksums, length checks)
+ * don't query the solver on every execution: each site, keyed by guest PC,
+ * is queried for its first N occurrences and then only when its count
+ * reaches a new power of two, much like AFL's hit-count classes. The other
+ * occurrences are concretized, and branches don't even build their
+ * expressions: the backend only takes path constraints together with a
+ * query, so there is no way to keep them without paying for the query that
+ * we want to save.
+ *
+ * The site table is shared by all threads. It is direct-mapped, so sites
+ * that collide start counting again; races between threads only make the
+ * counts approximate.
+ */
+#define SYM_BRANCH_SITE_BITS 14
+#define SYM_BRANCH_SITE_SIZE (1 << SYM_BRANCH_SITE_BITS)
+
+typedef struct SymBranchSite {
+    uint64_t pc;
+    uint64_t hits;
+    uint64_t suppressed;
+} SymBranchSite;
+
+static SymBranchSite sym_branch_sites[SYM_BRANCH_SITE_SIZE];
+static uint64_t sym_nb_queries;
+static bool sym_branch_report_done;
+
+static int sym_branch_site_compare(const void *a, const void *b)
+{
+    const SymBranchSite *site_a = *(const SymBranchSite * const *)a;
+    const SymBranchSite *site_b = *(const SymBranchSite * const *)b;
+
+    return site_a->suppressed < site_b->suppressed ? 1 :
+           site_a->suppressed > site_b->suppressed ? -1 : 0;
+}
+
+void sym_branch_report(void)
+{
+    g_autoptr(GPtrArray) sites = g_ptr_array_new();
+
+    if (qatomic_xchg(&sym_branch_report_done, true)) {
+        return;
+    }
+    for (int i = 0; i < SYM_BRANCH_SITE_SIZE; i++) {
+        if (sym_branch_sites[i].suppressed != 0) {
+            g_ptr_array_add(sites, &sym_branch_sites[i]);
+        }
+    }
+    if (sites->len == 0) {
+        return;
+    }
+
+    g_ptr_array_sort(sites, sym_branch_site_compare);
+    fprintf(stderr, "SymQEMU: queries suppressed by the branch budget:\n");
+    for (int i = 0; i < sites->len; i++) {
+        SymBranchSite *site = g_ptr_array_index(sites, i);
+
+        fprintf(stderr, "  pc 0x%" PRIx64 ": %" PRIu64 " of %" PRIu64 "\n",
+                site->pc, site->suppressed, site->hits);
+    }
+}
+
+SymBranchAction sym_branch_site_visit(uint64_t pc)
+{
+    uint32_t budget = qatomic_read(&sym_branch_budget);
+    SymBranchSite *site;
+    uint64_t hits;
+
+    if (budget == 0) {
+        return SYM_BRANCH_QUERY;
+    }
+
+    site = &sym_branch_sites[(uint32_t)(pc * 0x9e3779b97f4a7c15ull >>
+                                        (64 - SYM_BRANCH_SITE_BITS))];
+    if (site->pc != pc) {
+        site->pc = pc;
+        site->hits = 0;
+        site->suppressed = 0;
+    }
+    hits = ++site->hits;
+    if (hits <= budget || is_power_of_2(hits)) {
+        return SYM_BRANCH_QUERY;
+    }
+
+    if (site->suppressed++ == 0) {
+        static gsize registered;
+
+        if (g_once_init_enter(&registered)) {
+            atexit(sym_branch_report);
+            g_once_init_leave(&registered, 1);
+        }
+    }
+    return SYM_BRANCH_SKIP;
+}
+
+/*
+ * Queries passed to the backend; counts from several threads may race. In
+ * batch mode, this points to memory shared with the fork server.
+ */
+uint64_t *sym_query_counter = &sym_nb_queries;
+
+/*
+ * Tell the backend about the block that is being executed, if it doesn't know
+ * yet. Translated code only records the guest PC of each TB in the CPU state
+ * (see tcg_gen_sym_notify_block), so the backend sees exactly the blocks that
+ * query the solver, each time they do, and always before the query.
+ */
+static void sym_notify_pending_block(void)
+{
+    CPUState *cpu = current_cpu;
+
+    if (cpu != NULL && cpu->neg.sym_block_pc != 0) {
+        _sym_notify_basic_block(cpu->neg.sym_block_pc);
+        cpu->neg.sym_block_pc = 0;
+    }
+}
+
+void sym_query(SymExpr constraint, bool taken, uint64_t pc)
+{
+    sym_notify_pending_block();
+    (*sym_query_counter)++;
+    _sym_push_path_constraint(constraint, taken, pc);
+}
+
+void sym_push_path_constraint(SymBranchAction action, SymExpr constraint,
+                              bool taken, uint64_t pc)
+{
+    switch (action) {
+    case SYM_BRANCH_QUERY:
+        sym_query(constraint, taken, pc);
+        break;
+    case SYM_BRANCH_SKIP:
+        break;
+    }
+}
+
+SymExpr build_path_constraint(SymExpr arg1_expr, SymExpr arg2_expr,
+                              uint32_t comparison_operator)
+{
     void *(*handler)(void *, void*);
     switch (comparison_operator) {
         case TCG_COND_EQ:
@@ -79,22 +322,16 @@ void *build_and_push_path_constraint(CPUArchState *env, void *arg1_expr, void *a
             g_assert_not_reached();
     }
 
-    void *condition_symbol = handler(arg1_expr, arg2_expr);
-    _sym_push_path_constraint(condition_symbol, is_taken, get_pc(env));
-
-    return condition_symbol;
+    return handler(arg1_expr, arg2_expr);
 }
 
-/* Architecture-independent way to get the program counter */
-target_ulong get_pc(CPUArchState *env)
-{
-    vaddr pc;
-    uint64_t cs_base;
-    uint32_t flags;
-
-    cpu_get_tb_cpu_state(env, &pc, &cs_base, &flags);
+void *build_and_push_path_constraint(uint64_t pc, void *arg1_expr, void *arg2_expr, uint32_t comparison_operator, uint8_t is_taken){
+    SymBranchAction action = sym_branch_site_visit(pc);
+    void *condition_symbol =
+        build_path_constraint(arg1_expr, arg2_expr, comparison_operator);
 
-    return pc;
+    sym_push_path_constraint(action, condition_symbol, is_taken, pc);
+    return condition_symbol;
 }
 
 void *sym_rotate_left(void *arg1_expr, void *arg2_expr) {
@@ -107,7 +344,7 @@ void *sym_rotate_left(void *arg1_expr, void *arg2_expr) {
             _sym_build_shift_left(arg1_expr, arg2_expr),
             _sym_build_logical_shift_right(
                     arg1_expr,
-                    _sym_build_sub(_sym_build_integer(bits, bits), arg2_expr)));
+                    _sym_build_sub(sym_build_constant(bits, bits), arg2_expr)));
 }
 
 void *sym_rotate_right(void *arg1_expr, void *arg2_expr) {
@@ -121,5 +358,5 @@ void *sym_rotate_right(void *arg1_expr, void *arg2_expr) {
             _sym_build_logical_shift_right(arg1_expr, arg2_expr),
             _sym_build_shift_left(
                     arg1_expr,
-                    _sym_build_sub(_sym_build_integer(bits, bits), arg2_expr)));
+                    _sym_build_sub(sym_build_constant(bits, bits), arg2_expr)));
 }
@@ -1,4 +1,25 @@
-void *build_and_push_path_constraint(CPUArchState *env, void *arg1_expr, void *arg2_expr, uint32_t comparison_operator, uint8_t is_taken);
-target_ulong get_pc(CPUArchState *env);
+#ifndef ACCEL_TCG_RUNTIME_SYM_COMMON_H
+#define ACCEL_TCG_RUNTIME_SYM_COMMON_H
+
+typedef enum SymBranchAction {
+    SYM_BRANCH_QUERY,           /* push the constraint and query the solver */
+    SYM_BRANCH_SKIP,            /* drop the constraint */
+} SymBranchAction;
+
+/* Number of constraints passed to the backend's solver */
+extern uint64_t *sym_query_counter;
+
+void sym_query(void *constraint, bool taken, uint64_t pc);
+SymBranchAction sym_branch_site_visit(uint64_t pc);
+void sym_push_path_constraint(SymBranchAction action, void *constraint,
+                              bool taken, uint64_t pc);
+void sym_branch_report(void);
+void *build_path_constraint(void *arg1_expr, void *arg2_expr, uint32_t comparison_operator);
+void *build_and_push_path_constraint(uint64_t pc, void *arg1_expr, void *arg2_expr, uint32_t comparison_operator, uint8_t is_taken);
+void *sym_build_constant(uint64_t value, uint8_t bits);
+void sym_vec_set_symbolic_bytes(void *expr, uint32_t mask);
+uint32_t sym_vec_symbolic_bytes(void *expr, uint64_t length);
 void *sym_rotate_left(void *arg1_expr, void *arg2_expr);
 void *sym_rotate_right(void *arg1_expr, void *arg2_expr);
+
+#endif /* ACCEL_TCG_RUNTIME_SYM_COMMON_H */
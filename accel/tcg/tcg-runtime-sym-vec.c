@@ -30,22 +30,29 @@ void HELPER(free)(void *ptr) {
 }
 
 /*
- * Splits an expression into multiple expressions of equal size.
+ * Per-thread scratch arena for the element arrays of the helpers below.
  *
- * The expressions are stored in little endian order : result[0] is the least significant element of the original expression,
- * result[element_count - 1] is the most significant element.
- *
- * Args
- *      expression : the expression to split
- *      element_count : number of expressions to split into
- *      element_size : size of each result expression in bits
- *      result : array of size element_count to store the result
+ * Each helper resets the arena on entry and takes its arrays from it, so guest threads running SIMD code don't share
+ * any state. The arena is large enough for the arrays of the largest vector (256 bits of 8-bit elements).
  */
-static void split_expression(void *expression, uint64_t element_count, uint64_t element_size, void *result[]) {
-    g_assert(_sym_bits_helper(expression) % element_count == 0);
-    for (uint64_t i = 0; i < element_count; i++) {
-        result[i] = _sym_extract_helper(expression, (i + 1) * element_size - 1, i * element_size);
-    }
+#define SYM_VEC_MAX_ELEMENTS (256 / 8)
+#define SYM_VEC_ARENA_SIZE   (SYM_VEC_MAX_ELEMENTS * (2 * sizeof(void *) + sizeof(int)))
+
+static __thread struct {
+    uint64_t data[DIV_ROUND_UP(SYM_VEC_ARENA_SIZE, sizeof(uint64_t))];
+    size_t used;
+} sym_vec_arena;
+
+static void sym_vec_arena_reset(void) {
+    sym_vec_arena.used = 0;
+}
+
+static void *sym_vec_arena_alloc(size_t size) {
+    void *result = (uint8_t *)sym_vec_arena.data + sym_vec_arena.used;
+
+    sym_vec_arena.used += ROUND_UP(size, sizeof(uint64_t));
+    g_assert(sym_vec_arena.used <= sizeof(sym_vec_arena.data));
+    return result;
 }
 
 /* Pairwise applies a binary operation on two arrays of expressions and concatenates the result into a single expression.
@@ -79,6 +86,89 @@ static uint64_t vece_element_size(uint64_t vece) {
     return 8 << vece;
 }
 
+/*
+ * Computes the address of an element in a vector.
+ */
+static void *element_address(
+        void *concrete_vector,
+        uint64_t element_index,
+        uint64_t element_size,
+        uint64_t vector_size
+) {
+    void *result = concrete_vector + element_index * element_size / 8;
+    g_assert(result + element_size <= concrete_vector + vector_size);
+    return result;
+}
+
+/*
+ * Returns the mask of the bytes of an element in a vector (see sym_vec_symbolic_bytes).
+ */
+static uint32_t element_bytes(uint64_t element_index, uint64_t element_size) {
+    return MAKE_64BIT_MASK(element_index * element_size / 8, element_size / 8);
+}
+
+/*
+ * Returns the mask of the bytes of all elements that contain at least one symbolic byte.
+ */
+static uint32_t symbolic_elements(uint32_t symbolic_bytes, uint64_t element_count, uint64_t element_size) {
+    uint32_t result = 0;
+    for (uint64_t i = 0; i < element_count; i++) {
+        if (symbolic_bytes & element_bytes(i, element_size)) {
+            result |= element_bytes(i, element_size);
+        }
+    }
+    return result;
+}
+
+/*
+ * Splits a vector operand into expressions for its elements.
+ *
+ * The expressions are stored in little endian order : result[0] is the least significant element of the vector,
+ * result[element_count - 1] is the most significant element. Only the elements that contain symbolic bytes are
+ * extracted from the vector expression, the others are built as constants from the concrete value.
+ *
+ * Args
+ *      concrete : pointer to a buffer that stores the concrete value of the vector
+ *      symbolic : symbolic expression of the vector, NULL if it is concrete
+ *      symbolic_bytes : mask of the symbolic bytes of the vector, as returned by sym_vec_symbolic_bytes
+ *      element_count : number of elements in the vector
+ *      element_size : size of each element in bits
+ *      result : array of size element_count to store the result
+ */
+static void split_vector_operand(
+        void *concrete, void *symbolic, uint32_t symbolic_bytes,
+        uint64_t element_count, uint64_t element_size, void *result[]
+) {
+    uint64_t vector_size = element_count * element_size;
+
+    g_assert(symbolic == NULL || _sym_bits_helper(symbolic) == vector_size);
+    for (uint64_t i = 0; i < element_count; i++) {
+        void *element = element_address(concrete, i, element_size, vector_size);
+        uint64_t value;
+
+        if (symbolic_bytes & element_bytes(i, element_size)) {
+            result[i] = _sym_extract_helper(symbolic, (i + 1) * element_size - 1, i * element_size);
+            continue;
+        }
+
+        switch (element_size) {
+        case 8:
+            value = ldub_p(element);
+            break;
+        case 16:
+            value = lduw_he_p(element);
+            break;
+        case 32:
+            value = (uint32_t)ldl_he_p(element);
+            break;
+        default:
+            value = ldq_he_p(element);
+            break;
+        }
+        result[i] = sym_build_constant(value, element_size);
+    }
+}
+
 /*
  * Builds a symbolic expression for an SIMD operation on two vector operands.
  * Args
@@ -101,26 +191,61 @@ static void *build_expression_for_vector_vector_op(
     g_assert(vector_size % element_size == 0);
     uint64_t element_count = vector_size / element_size;
 
-    static void** arg1_elts      = NULL;
-    static void** arg2_elts      = NULL;
+    sym_vec_arena_reset();
+    void **arg1_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
+    void **arg2_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
 
-    static uint64_t arg_len = 0;
+    g_assert(vector_size == 64 || vector_size == 128 || vector_size == 256);
+    g_assert(element_size <= vector_size);
+
+    if (arg1_symbolic == NULL && arg2_symbolic == NULL) {
+        return NULL;
+    }
 
-    uint64_t arg_len_required = element_count * sizeof(void*);
-    if (arg_len < arg_len_required) {
-        arg1_elts = g_realloc(arg1_elts, arg_len_required);
-        arg2_elts = g_realloc(arg2_elts, arg_len_required);
+    uint32_t arg1_bytes = sym_vec_symbolic_bytes(arg1_symbolic, vector_size / 8);
+    uint32_t arg2_bytes = sym_vec_symbolic_bytes(arg2_symbolic, vector_size / 8);
+    uint32_t result_bytes = symbolic_elements(arg1_bytes | arg2_bytes, element_count, element_size);
 
-        arg_len = arg_len_required;
+    if (result_bytes == 0) {
+        /* No element of the result depends on symbolic data. */
+        return NULL;
     }
 
+    split_vector_operand(arg1_concrete, arg1_symbolic, arg1_bytes, element_count, element_size, arg1_elts);
+    split_vector_operand(arg2_concrete, arg2_symbolic, arg2_bytes, element_count, element_size, arg2_elts);
+
+    void *result = apply_op_and_merge(symbolic_operation, arg1_elts, arg2_elts, element_count);
+    g_assert(_sym_bits_helper(result) == vector_size);
+    sym_vec_set_symbolic_bytes(result, result_bytes);
+    return result;
+}
+
+/*
+ * Builds a symbolic expression for an SIMD operation that does not depend on the element size, like the bitwise
+ * operations: the operation is applied to the whole vectors at once instead of element by element.
+ * Args
+ *      arg1_concrete, arg2_concrete : pointers to buffers that store the concrete values of the input vector operands
+ *      arg1_symbolic, arg2_symbolic : symbolic expressions of the input vector operands
+ *      vector_size : size of the vectors in bits
+ *      symbolic_operation : function for the symbolic operation applied on the vectors
+ * Returns
+ *      A symbol expression that represents the output of the SIMD operation
+ */
+static void *build_expression_for_full_vector_op(
+        void *arg1_concrete, void *arg1_symbolic,
+        void *arg2_concrete, void *arg2_symbolic,
+        uint64_t vector_size,
+        void *(*symbolic_operation)(void *, void *)
+) {
     g_assert(vector_size == 64 || vector_size == 128 || vector_size == 256);
-    g_assert(element_size <= vector_size);
 
     if (arg1_symbolic == NULL && arg2_symbolic == NULL) {
         return NULL;
     }
 
+    uint32_t result_bytes = sym_vec_symbolic_bytes(arg1_symbolic, vector_size / 8) |
+                            sym_vec_symbolic_bytes(arg2_symbolic, vector_size / 8);
+
     if (arg1_symbolic == NULL) {
         arg1_symbolic = _sym_build_integer_from_buffer(arg1_concrete, vector_size);
     }
@@ -132,11 +257,8 @@ static void *build_expression_for_vector_vector_op(
     g_assert(_sym_bits_helper(arg1_symbolic) == _sym_bits_helper(arg2_symbolic) &&
              _sym_bits_helper(arg1_symbolic) == vector_size);
 
-    split_expression(arg1_symbolic, element_count, element_size, arg1_elts);
-    split_expression(arg2_symbolic, element_count, element_size, arg2_elts);
-
-    void *result = apply_op_and_merge(symbolic_operation, arg1_elts, arg2_elts, element_count);
-    g_assert(_sym_bits_helper(result) == vector_size);
+    void *result = symbolic_operation(arg1_symbolic, arg2_symbolic);
+    sym_vec_set_symbolic_bytes(result, result_bytes);
     return result;
 }
 
@@ -168,18 +290,9 @@ build_expression_for_vector_int32_op(
     g_assert(vector_size % element_size == 0);
     uint64_t element_count = vector_size / element_size;
 
-    static void** arg1_elts      = NULL;
-    static void** arg2_elts      = NULL;
-
-    static uint64_t arg_len = 0;
-
-    uint64_t arg_len_required = element_count * sizeof(void*);
-    if (arg_len < arg_len_required) {
-        arg1_elts = g_realloc(arg1_elts, arg_len_required);
-        arg2_elts = g_realloc(arg2_elts, arg_len_required);
-
-        arg_len = arg_len_required;
-    }
+    sym_vec_arena_reset();
+    void **arg1_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
+    void **arg2_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
 
     g_assert(vector_size == 64 || vector_size == 128 || vector_size == 256);
     g_assert(element_size <= vector_size);
@@ -188,41 +301,48 @@ build_expression_for_vector_int32_op(
         return NULL;
     }
 
-    if (arg1_symbolic == NULL) {
-        arg1_symbolic = _sym_build_integer_from_buffer(arg1_concrete, vector_size);
+    /* A symbolic integer operand makes every element of the result symbolic. */
+    uint32_t arg1_bytes = sym_vec_symbolic_bytes(arg1_symbolic, vector_size / 8);
+    uint32_t result_bytes = arg2_symbolic != NULL ? MAKE_64BIT_MASK(0, vector_size / 8)
+                                                  : symbolic_elements(arg1_bytes, element_count, element_size);
+
+    if (result_bytes == 0) {
+        return NULL;
     }
 
     if (arg2_symbolic == NULL) {
-        arg2_symbolic = _sym_build_integer(arg2_concrete, 32);
+        arg2_symbolic = sym_build_constant(arg2_concrete, 32);
     }
 
-    g_assert(_sym_bits_helper(arg1_symbolic) == vector_size);
     g_assert(_sym_bits_helper(arg2_symbolic) == 32);
 
-    if (element_size != 32) {
+    if (element_size > 32) {
         arg2_symbolic = _sym_build_zext(arg2_symbolic, element_size - 32);
+    } else if (element_size < 32) {
+        arg2_symbolic = _sym_extract_helper(arg2_symbolic, element_size - 1, 0);
     }
 
-    split_expression(arg1_symbolic, element_count, element_size, arg1_elts);
+    split_vector_operand(arg1_concrete, arg1_symbolic, arg1_bytes, element_count, element_size, arg1_elts);
     for (uint64_t i = 0; i < element_count; i++) {
         arg2_elts[i] = arg2_symbolic;
     }
 
     void *result = apply_op_and_merge(symbolic_operation, arg1_elts, arg2_elts, element_count);
     g_assert(_sym_bits_helper(result) == vector_size);
+    sym_vec_set_symbolic_bytes(result, result_bytes);
     return result;
 }
 
 void *HELPER(sym_and_vec)(void *arg1, void *arg1_expr, void *arg2, void *arg2_expr, uint64_t size, uint64_t vece) {
-    return build_expression_for_vector_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, vece, _sym_build_and);
+    return build_expression_for_full_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, _sym_build_and);
 }
 
 void *HELPER(sym_or_vec)(void *arg1, void *arg1_expr, void *arg2, void *arg2_expr, uint64_t size, uint64_t vece) {
-    return build_expression_for_vector_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, vece, _sym_build_or);
+    return build_expression_for_full_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, _sym_build_or);
 }
 
 void *HELPER(sym_xor_vec)(void *arg1, void *arg1_expr, void *arg2, void *arg2_expr, uint64_t size, uint64_t vece) {
-    return build_expression_for_vector_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, vece, _sym_build_xor);
+    return build_expression_for_full_vector_op(arg1, arg1_expr, arg2, arg2_expr, size, _sym_build_xor);
 }
 
 void *HELPER(sym_add_vec)(void *arg1, void *arg1_expr, void *arg2, void *arg2_expr, uint64_t size, uint64_t vece) {
@@ -369,20 +489,6 @@ void *HELPER(sym_load_and_duplicate_into_vec)(
     return helper_sym_duplicate_value_into_vec(value_expr, vector_size, vece);
 }
 
-/*
- * Computes the address of an element in a vector.
- */
-static void *element_address(
-        void *concrete_vector,
-        uint64_t element_index,
-        uint64_t element_size,
-        uint64_t vector_size
-) {
-    void *result = concrete_vector + element_index * element_size / 8;
-    g_assert(result + element_size <= concrete_vector + vector_size);
-    return result;
-}
-
 /*
 TODO:
     Currently, `helper_sym_cmp_vec` pushes path constraints and concretizes its result.
@@ -400,6 +506,7 @@ TODO:
  * and path constraints are pushed accordingly.
  *
  * Args
+ *   pc : address of the guest instruction, identifies the site of the path constraints
  *   arg1_concrete, arg2_concrete : pointers to buffers that store the concrete values of the input vector operands
  *   arg1_symbolic, arg2_symbolic : symbolic expressions of the input vector operands
  *   comparison_operator : enum value that represents a comparison operator like <, >, ==, etc.
@@ -410,7 +517,7 @@ TODO:
  *
  */
 void *HELPER(sym_cmp_vec)(
-        CPUArchState *env,
+        uint64_t pc,
         void *arg1_concrete, void *arg1_symbolic,
         void *arg2_concrete, void *arg2_symbolic,
         /* TCGCond */ uint32_t comparison_operator, void *result_concrete,
@@ -421,18 +528,9 @@ void *HELPER(sym_cmp_vec)(
     g_assert(vector_size % element_size == 0);
     uint64_t element_count = vector_size / element_size;
 
-    static void** arg1_elts      = NULL;
-    static void** arg2_elts      = NULL;
-
-    static uint64_t arg_len = 0;
-
-    uint64_t arg_len_required = element_count * sizeof(void*);
-    if (arg_len < arg_len_required) {
-        arg1_elts = g_realloc(arg1_elts, arg_len_required);
-        arg2_elts = g_realloc(arg2_elts, arg_len_required);
-
-        arg_len = arg_len_required;
-    }
+    sym_vec_arena_reset();
+    void **arg1_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
+    void **arg2_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
 
     g_assert(vector_size == 64 || vector_size == 128 || vector_size == 256);
     g_assert(element_size <= vector_size);
@@ -442,26 +540,23 @@ void *HELPER(sym_cmp_vec)(
         return NULL;
     }
 
-    if (arg1_symbolic == NULL) {
-        arg1_symbolic = _sym_build_integer_from_buffer(arg1_concrete, vector_size);
-    }
+    uint32_t arg1_bytes = sym_vec_symbolic_bytes(arg1_symbolic, vector_size / 8);
+    uint32_t arg2_bytes = sym_vec_symbolic_bytes(arg2_symbolic, vector_size / 8);
 
-    if (arg2_symbolic == NULL) {
-        arg2_symbolic = _sym_build_integer_from_buffer(arg2_concrete, vector_size);
-    }
-
-    g_assert(_sym_bits_helper(arg1_symbolic) == _sym_bits_helper(arg2_symbolic) &&
-             _sym_bits_helper(arg1_symbolic) == vector_size);
-
-    split_expression(arg1_symbolic, element_count, element_size, arg1_elts);
-    split_expression(arg2_symbolic, element_count, element_size, arg2_elts);
+    split_vector_operand(arg1_concrete, arg1_symbolic, arg1_bytes, element_count, element_size, arg1_elts);
+    split_vector_operand(arg2_concrete, arg2_symbolic, arg2_bytes, element_count, element_size, arg2_elts);
 
     for (uint64_t i = 0; i < element_count; i++) {
+        /* Comparisons of concrete elements don't constrain anything. */
+        if (!((arg1_bytes | arg2_bytes) & element_bytes(i, element_size))) {
+            continue;
+        }
+
         /* For each element, the comparison was true iff the element of the result is equal to -1.
         * Here it is ok to take the first byte of the element, because the result is either -1 or 0. */
         uint8_t is_taken = *(uint8_t *) element_address(result_concrete, i, element_size, vector_size);
         build_and_push_path_constraint(
-                env,
+                pc,
                 arg1_elts[i],
                 arg2_elts[i],
                 comparison_operator,
@@ -492,6 +587,7 @@ TODO:
  * and path constraints are pushed accordingly.
  *
  * Args
+ *      pc : address of the guest instruction, identifies the site of the path constraints
  *      arg1_concrete, arg2_concrete : pointers to buffers that store the concrete values of the input vector operands
  *      arg1_symbolic, arg2_symbolic : symbolic expressions of the input vector operands
  *      comparison_operator : enum value that represents a comparison operator like <, >, ==, etc.
@@ -503,7 +599,7 @@ TODO:
  *      An expression that corresponds to the symbolic result of the SIMD operation
  */
 void *HELPER(sym_ternary_vec)(
-        CPUArchState *env,
+        uint64_t pc,
         void *arg1_concrete, void *arg1_symbolic,
         void *arg2_concrete, void *arg2_symbolic,
         /* TCGCond */ uint32_t comparison_operator, void *concrete_result,
@@ -514,30 +610,13 @@ void *HELPER(sym_ternary_vec)(
     g_assert(vector_size % element_size == 0);
     uint64_t element_count = vector_size / element_size;
 
-    static void** arg1_elts      = NULL;
-    static void** arg2_elts      = NULL;
+    sym_vec_arena_reset();
+    void **arg1_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
+    void **arg2_elts = sym_vec_arena_alloc(element_count * sizeof(void *));
 
     /* For each element, the condition of the ternary was true iff the element of the result is equal to the element
      * of arg1. */
-    static int* concrete_condition_was_true = NULL;
-
-    static uint64_t arg_len = 0;
-    static uint64_t concrete_condition_len = 0;
-
-    uint64_t arg_len_required = element_count * sizeof(void*);
-    if (arg_len < arg_len_required) {
-        arg1_elts = g_realloc(arg1_elts, arg_len_required);
-        arg2_elts = g_realloc(arg2_elts, arg_len_required);
-
-        arg_len = arg_len_required;
-    }
-
-    uint64_t concrete_condition_len_required = element_count * sizeof(int);
-    if (concrete_condition_len < concrete_condition_len_required) {
-        concrete_condition_was_true = g_realloc(concrete_condition_was_true, concrete_condition_len_required);
-
-        concrete_condition_len = concrete_condition_len_required;
-    }
+    int *concrete_condition_was_true = sym_vec_arena_alloc(element_count * sizeof(int));
 
     g_assert(vector_size == 64 || vector_size == 128 || vector_size == 256);
     g_assert(element_size <= vector_size);
@@ -546,19 +625,12 @@ void *HELPER(sym_ternary_vec)(
         return NULL;
     }
 
-    if (arg1_symbolic == NULL) {
-        arg1_symbolic = _sym_build_integer_from_buffer(arg1_concrete, vector_size);
-    }
+    uint32_t arg1_bytes = sym_vec_symbolic_bytes(arg1_symbolic, vector_size / 8);
+    uint32_t arg2_bytes = sym_vec_symbolic_bytes(arg2_symbolic, vector_size / 8);
+    uint32_t result_bytes = 0;
 
-    if (arg2_symbolic == NULL) {
-        arg2_symbolic = _sym_build_integer_from_buffer(arg2_concrete, vector_size);
-    }
-
-    g_assert(_sym_bits_helper(arg1_symbolic) == _sym_bits_helper(arg2_symbolic) &&
-             _sym_bits_helper(arg1_symbolic) == vector_size);
-
-    split_expression(arg1_symbolic, element_count, element_size, arg1_elts);
-    split_expression(arg2_symbolic, element_count, element_size, arg2_elts);
+    split_vector_operand(arg1_concrete, arg1_symbolic, arg1_bytes, element_count, element_size, arg1_elts);
+    split_vector_operand(arg2_concrete, arg2_symbolic, arg2_bytes, element_count, element_size, arg2_elts);
 
     for (int i = 0; i < element_count; i++) {
         void *result_element_ptr = element_address(concrete_result, i, element_size, vector_size);
@@ -567,13 +639,28 @@ void *HELPER(sym_ternary_vec)(
     }
 
     for (int i = 0; i < element_count; i++) {
+        uint32_t bytes = element_bytes(i, element_size);
+
+        /* Conditions on concrete elements don't constrain anything. */
+        if (!((arg1_bytes | arg2_bytes) & bytes)) {
+            continue;
+        }
+
         build_and_push_path_constraint(
-                env,
+                pc,
                 arg1_elts[i],
                 arg2_elts[i],
                 comparison_operator,
                 concrete_condition_was_true[i]
         );
+        if ((concrete_condition_was_true[i] ? arg1_bytes : arg2_bytes) & bytes) {
+            result_bytes |= bytes;
+        }
+    }
+
+    if (result_bytes == 0) {
+        /* Only concrete elements were selected. */
+        return NULL;
     }
 
     void *result_expression = concrete_condition_was_true[0] ? arg1_elts[0] : arg2_elts[0];
@@ -583,5 +670,6 @@ void *HELPER(sym_ternary_vec)(
     }
 
     g_assert(_sym_bits_helper(result_expression) == vector_size);
+    sym_vec_set_symbolic_bytes(result_expression, result_bytes);
     return result_expression;
 }
@@ -22,6 +22,11 @@
 #include "tcg/tcg.h"
 #include "exec/translation-block.h"
 #include "accel/tcg/tcg-runtime-sym-common.h"
+#include "tcg/sym-program.h"
+#include "tcg/sym-page-map.h"
+#include "tcg/sym-fork-server.h"
+#include "internal-common.h"
+#include "internal-target.h"
 
 #define HELPER_H  "accel/tcg/tcg-runtime-sym.h"
 #include "exec/helper-info.c.inc"
@@ -49,11 +54,11 @@
     }                                                                          \
                                                                                \
     if (arg1_expr == NULL) {                                                   \
-        arg1_expr = _sym_build_integer(arg1, _sym_bits_helper(arg2_expr));     \
+        arg1_expr = sym_build_constant(arg1, _sym_bits_helper(arg2_expr));     \
     }                                                                          \
                                                                                \
     if (arg2_expr == NULL) {                                                   \
-        arg2_expr = _sym_build_integer(arg2, _sym_bits_helper(arg1_expr));     \
+        arg2_expr = sym_build_constant(arg2, _sym_bits_helper(arg1_expr));     \
     }                                                                          \
                                                                                \
     assert(_sym_bits_helper(arg1_expr) == 32 ||                                \
@@ -175,12 +180,12 @@ void *HELPER(sym_sext)(void *expr, uint64_t target_length)
 
     size_t current_bits = _sym_bits_helper(expr);
     size_t bits_to_keep = target_length * 8;
-    void *shift_distance_expr = _sym_build_integer(
-        current_bits - bits_to_keep, current_bits);
 
-    return _sym_build_arithmetic_shift_right(
-        _sym_build_shift_left(expr, shift_distance_expr),
-        shift_distance_expr);
+    if (bits_to_keep >= current_bits)
+        return expr;
+
+    return _sym_build_sext(_sym_build_trunc(expr, bits_to_keep),
+                           current_bits - bits_to_keep);
 }
 
 void *HELPER(sym_zext)(void *expr, uint64_t target_length)
@@ -191,9 +196,11 @@ void *HELPER(sym_zext)(void *expr, uint64_t target_length)
     size_t current_bits = _sym_bits_helper(expr);
     size_t desired_bits = target_length * 8;
 
-    return _sym_build_and(
-        expr,
-        _sym_build_integer((1ull << desired_bits) - 1, current_bits));
+    if (desired_bits >= current_bits)
+        return expr;
+
+    return _sym_build_zext(_sym_build_trunc(expr, desired_bits),
+                           current_bits - desired_bits);
 }
 
 void *HELPER(sym_sext_i32_i64)(void *expr)
@@ -228,80 +235,104 @@ void *HELPER(sym_bswap)(void *expr, uint64_t length)
     if (expr == NULL)
         return NULL;
 
-    /* The implementation follows the alternative implementations of
-     * tcg_gen_bswap* in tcg-op.c (which handle architectures that don't support
-     * bswap directly). */
+    /* Concatenate the low "length" bytes in reverse order, with the least
+     * significant input byte ending up most significant. Like the concrete
+     * operation with TCG_BSWAP_IZ/OZ, the result is zero-extended. */
 
     size_t bits = _sym_bits_helper(expr);
-    void *eight = _sym_build_integer(8, bits);
-    void *sixteen = _sym_build_integer(16, bits);
-    void *thirty_two = _sym_build_integer(32, bits);
-    void *forty_eight = _sym_build_integer(48, bits);
-
-    switch (length) {
-    case 2:
-        return _sym_build_or(
-            _sym_build_shift_left(HELPER(sym_zext)(expr, 1), eight),
-            _sym_build_logical_shift_right(expr, eight));
-    case 4: {
-        void *mask = _sym_build_integer(0x00ff00ff, bits);
-
-        /* This is equivalent to the temporary "ret" after the first block. */
-        void *first_block = _sym_build_or(
-            _sym_build_and(
-                _sym_build_logical_shift_right(expr, eight),
-                mask),
-            _sym_build_shift_left(_sym_build_and(expr, mask), eight));
-
-        /* This is the second block. */
-        if (bits == 32)
-            return _sym_build_or(
-                _sym_build_logical_shift_right(first_block, sixteen),
-                _sym_build_shift_left(first_block, sixteen));
-        else
-            return _sym_build_or(
-                _sym_build_logical_shift_right(first_block, sixteen),
-                _sym_build_logical_shift_right(
-                    _sym_build_shift_left(first_block, forty_eight),
-                    thirty_two));
+    void *result = _sym_extract_helper(expr, 7, 0);
+
+    assert(length * 8 <= bits);
+    for (uint64_t i = 1; i < length; i++)
+        result = _sym_concat_helper(
+            result, _sym_extract_helper(expr, i * 8 + 7, i * 8));
+
+    if (length * 8 == bits)
+        return result;
+    return _sym_build_zext(result, bits - length * 8);
+}
+
+/*
+ * Cache of the address constraints pushed for symbolic pointers
+ *
+ * An access through a symbolic pointer pins the pointer to its concrete value
+ * with a path constraint. In a loop, the same site sees the same address
+ * expression over and over, and pushing the constraint again only makes the
+ * backend solve the same query once more. We therefore remember, per site
+ * (guest PC), the address expression and the concrete address of the last
+ * constraint, and skip accesses that match all three.
+ *
+ * Like the other caches, this one is direct-mapped and per thread, and its
+ * expressions are registered with the garbage collector.
+ */
+#define SYM_ADDR_CACHE_BITS 8
+#define SYM_ADDR_CACHE_SIZE (1 << SYM_ADDR_CACHE_BITS)
+
+typedef struct SymAddrCacheEntry {
+    uint64_t pc;
+    target_ulong addr;
+} SymAddrCacheEntry;
+
+static __thread SymAddrCacheEntry *sym_addr_entries;
+static __thread void **sym_addr_exprs;
+
+static void sym_push_address_constraint(uint64_t pc,
+                                       target_ulong addr, void *addr_expr)
+{
+    uint8_t bits = sizeof(addr) * 8;
+    SymAddrCacheEntry *entry;
+    uint32_t idx;
+
+    if (addr_expr == NULL) {
+        return;
     }
-    case 8: {
-        void *mask1 = _sym_build_integer(0x00ff00ff00ff00ffull, 64);
-        void *mask2 = _sym_build_integer(0x0000ffff0000ffffull, 64);
-
-        /* This is equivalent to the temporary "ret" after the first block. */
-        void *first_block = _sym_build_or(
-            _sym_build_and(_sym_build_logical_shift_right(expr, eight), mask1),
-            _sym_build_shift_left(_sym_build_and(expr, mask1), eight));
-
-        /* Here we replicate the second block. */
-        void *second_block = _sym_build_or(
-            _sym_build_and(
-                _sym_build_logical_shift_right(first_block, sixteen),
-                mask2),
-            _sym_build_shift_left(_sym_build_and(first_block, mask2), sixteen));
-
-        /* And finally the third block. */
-        return _sym_build_or(
-            _sym_build_logical_shift_right(second_block, thirty_two),
-            _sym_build_shift_left(second_block, thirty_two));
+
+    if (unlikely(sym_addr_exprs == NULL)) {
+        sym_addr_entries = g_new0(SymAddrCacheEntry, SYM_ADDR_CACHE_SIZE);
+        sym_addr_exprs = g_new0(void *, SYM_ADDR_CACHE_SIZE);
+        _sym_register_expression_region(
+            sym_addr_exprs, SYM_ADDR_CACHE_SIZE * sizeof(void *));
     }
-    default:
-        g_assert_not_reached();
+
+    idx = (uint32_t)((pc ^ (uintptr_t)addr_expr) * 0x9e3779b97f4a7c15ull >>
+                     (64 - SYM_ADDR_CACHE_BITS));
+    entry = &sym_addr_entries[idx];
+    if (sym_addr_exprs[idx] == addr_expr && entry->pc == pc &&
+        entry->addr == addr) {
+        return;
+    }
+
+    sym_addr_exprs[idx] = addr_expr;
+    entry->pc = pc;
+    entry->addr = addr;
+
+    /* Try an alternative address */
+    sym_query(_sym_build_equal(addr_expr, sym_build_constant(addr, bits)),
+              true, pc);
+}
+
+uint8_t sym_page_map[SYM_PAGE_MAP_SIZE];
+
+/* Symbolize mapped input before its first access (see sym-page-map.h). */
+static inline void sym_input_map_check(uint64_t addr, uint64_t length)
+{
+#ifdef CONFIG_LINUX_USER
+    if (unlikely(sym_page_map[sym_page_map_index(addr)] ==
+                 SYM_PAGE_MAP_INPUT ||
+                 sym_page_map[sym_page_map_index(addr + length - 1)] ==
+                 SYM_PAGE_MAP_INPUT)) {
+        sym_input_map_touch(addr, length);
     }
+#endif
 }
 
 static void *sym_load_guest_internal(CPUArchState *env,
                                      target_ulong addr, void *addr_expr,
                                      uint64_t load_length, uint8_t result_length,
-                                     target_ulong mmu_idx)
+                                     target_ulong mmu_idx, uint64_t pc)
 {
-    /* Try an alternative address */
-    if (addr_expr != NULL)
-        _sym_push_path_constraint(
-            _sym_build_equal(
-                addr_expr, _sym_build_integer(addr, sizeof(addr) * 8)),
-            true, get_pc(env));
+    sym_push_address_constraint(pc, addr, addr_expr);
+    sym_input_map_check(addr, load_length);
 
     void *host_addr = tlb_vaddr_to_host(env, addr, MMU_DATA_LOAD, mmu_idx);
     void *memory_expr = _sym_read_memory((uint8_t*)host_addr, load_length, true);
@@ -314,29 +345,67 @@ static void *sym_load_guest_internal(CPUArchState *env,
 
 void *HELPER(sym_load_guest_i32)(CPUArchState *env,
                                  uint64_t addr, void *addr_expr,
-                                 uint64_t length, uint64_t mmu_idx)
+                                 uint64_t length, uint64_t mmu_idx,
+                                 uint64_t pc)
 {
-    return sym_load_guest_internal(env, addr, addr_expr, length, 4, mmu_idx);
+    return sym_load_guest_internal(env, addr, addr_expr, length, 4, mmu_idx,
+                                   pc);
 }
 
 void *HELPER(sym_load_guest_i64)(CPUArchState *env,
                                  uint64_t addr, void *addr_expr,
-                                 uint64_t length, uint64_t mmu_idx)
+                                 uint64_t length, uint64_t mmu_idx,
+                                 uint64_t pc)
+{
+    return sym_load_guest_internal(env, addr, addr_expr, length, 8, mmu_idx,
+                                   pc);
+}
+
+void HELPER(sym_address_constraint)(uint64_t pc,
+                                    uint64_t addr, void *addr_expr)
 {
-    return sym_load_guest_internal(env, addr, addr_expr, length, 8, mmu_idx);
+    /* Replaces a guest load whose expression is unused (see
+     * sym_drop_dead_expression in tcg/tcg.c). */
+    sym_push_address_constraint(pc, addr, addr_expr);
+}
+
+void HELPER(sym_check_concrete_load)(CPUArchState *env, uint64_t addr,
+                                     uint64_t length, uint64_t mmu_idx)
+{
+    /* Called from the concrete clone of a TB after a guest load. If the loaded
+     * bytes are symbolic, the clone is no longer exact: restart the current
+     * instruction in the instrumented variant. TCG synced the globals before
+     * the load, so the guest state is the one at the start of the
+     * instruction. */
+    void *host_addr = tlb_vaddr_to_host(env, addr, MMU_DATA_LOAD, mmu_idx);
+
+    sym_input_map_check(addr, length);
+    if (_sym_read_memory((uint8_t*)host_addr, length, true) != NULL) {
+        CPUState *cpu = env_cpu(env);
+
+        cpu->sym_force_instrumented = true;
+        cpu_loop_exit_restore(cpu, GETPC());
+    }
 }
 
 static void sym_store_guest_internal(CPUArchState *env,
                                      uint64_t value, void *value_expr,
                                      uint64_t addr, void *addr_expr,
-                                     uint64_t length, target_ulong mmu_idx)
+                                     uint64_t length, target_ulong mmu_idx,
+                                     uint64_t pc)
 {
-    /* Try an alternative address */
-    if (addr_expr != NULL)
-        _sym_push_path_constraint(
-            _sym_build_equal(
-                addr_expr, _sym_build_integer(addr, sizeof(addr) * 8)),
-            true, get_pc(env));
+    sym_push_address_constraint(pc, addr, addr_expr);
+    sym_input_map_check(addr, length);
+
+    if (value_expr != NULL) {
+        sym_page_map_mark(addr, length);
+    }
+#ifdef CONFIG_USER_ONLY
+    else if (!sym_page_map_test(addr)) {
+        /* There is no symbolic data to overwrite. */
+        return;
+    }
+#endif
 
     void *host_addr = tlb_vaddr_to_host(env, addr, MMU_DATA_STORE, mmu_idx);
     _sym_write_memory((uint8_t*)host_addr, length, value_expr, true);
@@ -345,19 +414,21 @@ static void sym_store_guest_internal(CPUArchState *env,
 void HELPER(sym_store_guest_i32)(CPUArchState *env,
                                  uint32_t value, void *value_expr,
                                  uint64_t addr, void *addr_expr,
-                                 uint64_t length, uint64_t mmu_idx)
+                                 uint64_t length, uint64_t mmu_idx,
+                                 uint64_t pc)
 {
     return sym_store_guest_internal(
-        env, value, value_expr, addr, addr_expr, length, mmu_idx);
+        env, value, value_expr, addr, addr_expr, length, mmu_idx, pc);
 }
 
 void HELPER(sym_store_guest_i64)(CPUArchState *env,
                                  uint64_t value, void *value_expr,
                                  uint64_t addr, void *addr_expr,
-                                 uint64_t length, uint64_t mmu_idx)
+                                 uint64_t length, uint64_t mmu_idx,
+                                 uint64_t pc)
 {
     return sym_store_guest_internal(
-        env, value, value_expr, addr, addr_expr, length, mmu_idx);
+        env, value, value_expr, addr, addr_expr, length, mmu_idx, pc);
 }
 
 static void *sym_load_host_internal(void *addr, uint64_t offset,
@@ -384,12 +455,30 @@ void *HELPER(sym_load_host_i64)(void *addr, uint64_t offset, uint64_t length)
 
 void *HELPER(sym_load_host_vec)(void *addr, uint64_t offset, uint64_t length)
 {
-    return sym_load_host_internal(addr, offset, length, length);
+    void *expr = sym_load_host_internal(addr, offset, length, length);
+    uint32_t symbolic_bytes = 0;
+
+    /* Tell the vector helpers which lanes they need to look at. */
+    if (expr != NULL && length <= 32) {
+        for (uint64_t i = 0; i < length; i++) {
+            if (_sym_read_memory((uint8_t*)addr + offset + i, 1, true)) {
+                symbolic_bytes |= 1u << i;
+            }
+        }
+        sym_vec_set_symbolic_bytes(expr, symbolic_bytes);
+    }
+    return expr;
 }
 
 void HELPER(sym_store_host)(void *value_expr, void *addr,
                                 uint64_t offset, uint64_t length)
 {
+    /* Host stores target the CPU state; remember which part of it may hold
+     * symbolic data, so that the concrete clones of TBs are not used (see
+     * sym_select_variant). */
+    if (value_expr != NULL && current_cpu != NULL) {
+        sym_env_mark_symbolic(current_cpu, (uint8_t*)addr + offset, length);
+    }
     _sym_write_memory((uint8_t*)addr + offset, length, value_expr, true);
 }
 
@@ -406,7 +495,7 @@ DECL_HELPER_BINARY(rotate_left)
         _sym_build_shift_left(arg1_expr, arg2_expr),
         _sym_build_logical_shift_right(
             arg1_expr,
-            _sym_build_sub(_sym_build_integer(bits, bits), arg2_expr)));
+            _sym_build_sub(sym_build_constant(bits, bits), arg2_expr)));
 }
 
 DECL_HELPER_BINARY(rotate_right)
@@ -422,7 +511,7 @@ DECL_HELPER_BINARY(rotate_right)
         _sym_build_logical_shift_right(arg1_expr, arg2_expr),
         _sym_build_shift_left(
             arg1_expr,
-            _sym_build_sub(_sym_build_integer(bits, bits), arg2_expr)));
+            _sym_build_sub(sym_build_constant(bits, bits), arg2_expr)));
 }
 
 void *HELPER(sym_extract_i32)(void *expr, uint32_t ofs, uint32_t len)
@@ -448,10 +537,10 @@ void *HELPER(sym_extract2_i32)(uint32_t ah, void *ah_expr,
         return NULL;
 
     if (ah_expr == NULL)
-        ah_expr = _sym_build_integer(ah, 32);
+        ah_expr = sym_build_constant(ah, 32);
 
     if (al_expr == NULL)
-        al_expr = _sym_build_integer(al, 32);
+        al_expr = sym_build_constant(al, 32);
 
     /* The implementation follows the alternative implementation of
      * tcg_gen_extract2_i32 in tcg-op.c (which handles architectures that don't
@@ -466,7 +555,7 @@ void *HELPER(sym_extract2_i32)(uint32_t ah, void *ah_expr,
         al >> ofs,
         _sym_build_logical_shift_right(
             al_expr,
-            _sym_build_integer(ofs, 32)),
+            sym_build_constant(ofs, 32)),
         ah, ah_expr,
         32 - ofs,
         ofs);
@@ -480,10 +569,10 @@ void *HELPER(sym_extract2_i64)(uint64_t ah, void *ah_expr,
         return NULL;
 
     if (ah_expr == NULL)
-        ah_expr = _sym_build_integer(ah, 64);
+        ah_expr = sym_build_constant(ah, 64);
 
     if (al_expr == NULL)
-        al_expr = _sym_build_integer(al, 64);
+        al_expr = sym_build_constant(al, 64);
 
     /* The implementation follows the alternative implementation of
      * tcg_gen_extract2_i64 in tcg-op.c (which handles architectures that don't
@@ -498,7 +587,7 @@ void *HELPER(sym_extract2_i64)(uint64_t ah, void *ah_expr,
         al >> ofs,
         _sym_build_logical_shift_right(
             al_expr,
-            _sym_build_integer(ofs, 64)),
+            sym_build_constant(ofs, 64)),
         ah, ah_expr,
         64 - ofs,
         ofs);
@@ -533,10 +622,10 @@ void *HELPER(sym_deposit_i32)(uint32_t arg1, void *arg1_expr,
     return _sym_build_or(
         _sym_build_and(
             arg1_expr,
-            _sym_build_integer(~(mask << ofs), 32)),
+            sym_build_constant(~(mask << ofs), 32)),
         _sym_build_shift_left(
-            _sym_build_and(arg2_expr, _sym_build_integer(mask, 32)),
-            _sym_build_integer(ofs, 32)));
+            _sym_build_and(arg2_expr, sym_build_constant(mask, 32)),
+            sym_build_constant(ofs, 32)));
 }
 
 void *HELPER(sym_deposit_i64)(uint64_t arg1, void *arg1_expr,
@@ -553,13 +642,13 @@ void *HELPER(sym_deposit_i64)(uint64_t arg1, void *arg1_expr,
     return _sym_build_or(
         _sym_build_and(
             arg1_expr,
-            _sym_build_integer(~(mask << ofs), 64)),
+            sym_build_constant(~(mask << ofs), 64)),
         _sym_build_shift_left(
-            _sym_build_and(arg2_expr, _sym_build_integer(mask, 64)),
-            _sym_build_integer(ofs, 64)));
+            _sym_build_and(arg2_expr, sym_build_constant(mask, 64)),
+            sym_build_constant(ofs, 64)));
 }
 
-static void *sym_setcond_internal(CPUArchState *env,
+static void *sym_setcond_internal(uint64_t pc,
                                   uint64_t arg1, void *arg1_expr,
                                   uint64_t arg2, void *arg2_expr,
                                   int32_t comparison_operator, uint64_t is_taken,
@@ -567,32 +656,120 @@ static void *sym_setcond_internal(CPUArchState *env,
 {
     BINARY_HELPER_ENSURE_EXPRESSIONS;
 
-    void *condition_symbol = build_and_push_path_constraint(env, arg1_expr, arg2_expr, comparison_operator, is_taken);
+    void *condition_symbol = build_and_push_path_constraint(pc, arg1_expr, arg2_expr, comparison_operator, is_taken);
 
     assert(result_bits > 1);
     return _sym_build_zext(_sym_build_bool_to_bit(condition_symbol),
                            result_bits - 1);
 }
 
-void *HELPER(sym_setcond_i32)(CPUArchState *env,
+void *HELPER(sym_setcond_i32)(uint64_t pc,
                               uint32_t arg1, void *arg1_expr,
                               uint32_t arg2, void *arg2_expr,
                               int32_t comparison_operator, uint32_t is_taken)
 {
     return sym_setcond_internal(
-            env, arg1, arg1_expr, arg2, arg2_expr, comparison_operator, is_taken, 32);
+            pc, arg1, arg1_expr, arg2, arg2_expr, comparison_operator, is_taken, 32);
 }
 
-void *HELPER(sym_setcond_i64)(CPUArchState *env,
+void *HELPER(sym_setcond_i64)(uint64_t pc,
                               uint64_t arg1, void *arg1_expr,
                               uint64_t arg2, void *arg2_expr,
                               int32_t comparison_operator, uint64_t is_taken)
 {
     return sym_setcond_internal(
-            env, arg1, arg1_expr, arg2, arg2_expr, comparison_operator, is_taken, 64);
+            pc, arg1, arg1_expr, arg2, arg2_expr, comparison_operator, is_taken, 64);
 }
 
-static void *sym_movcond_internal(CPUArchState *env,
+/* Evaluate a TCG comparison on the concrete operands of a branch. */
+static bool sym_cond_holds(int32_t comparison_operator,
+                           uint64_t arg1, uint64_t arg2, uint8_t bits)
+{
+    int64_t sarg1 = bits == 32 ? (int32_t)arg1 : (int64_t)arg1;
+    int64_t sarg2 = bits == 32 ? (int32_t)arg2 : (int64_t)arg2;
+
+    switch (comparison_operator) {
+    case TCG_COND_EQ:
+        return arg1 == arg2;
+    case TCG_COND_NE:
+        return arg1 != arg2;
+    case TCG_COND_TSTEQ:
+        return (arg1 & arg2) == 0;
+    case TCG_COND_TSTNE:
+        return (arg1 & arg2) != 0;
+    case TCG_COND_LT:
+        return sarg1 < sarg2;
+    case TCG_COND_GE:
+        return sarg1 >= sarg2;
+    case TCG_COND_GT:
+        return sarg1 > sarg2;
+    case TCG_COND_LE:
+        return sarg1 <= sarg2;
+    case TCG_COND_LTU:
+        return arg1 < arg2;
+    case TCG_COND_GEU:
+        return arg1 >= arg2;
+    case TCG_COND_GTU:
+        return arg1 > arg2;
+    case TCG_COND_LEU:
+        return arg1 <= arg2;
+    default:
+        g_assert_not_reached();
+    }
+}
+
+static void sym_brcond_internal(uint64_t pc,
+                                uint64_t arg1, void *arg1_expr,
+                                uint64_t arg2, void *arg2_expr,
+                                int32_t comparison_operator, uint8_t bits)
+{
+    SymBranchAction action;
+
+    if (arg1_expr == NULL && arg2_expr == NULL) {
+        return;
+    }
+
+    /* Decide on the query before building anything for the branch. */
+    action = sym_branch_site_visit(pc);
+    if (action == SYM_BRANCH_SKIP) {
+        return;
+    }
+
+    if (arg1_expr == NULL) {
+        arg1_expr = sym_build_constant(arg1, bits);
+    }
+
+    if (arg2_expr == NULL) {
+        arg2_expr = sym_build_constant(arg2, bits);
+    }
+
+    /* Unlike setcond, a branch has no result value, so we only need the path
+     * constraint; the direction follows from the concrete operands. */
+    sym_push_path_constraint(
+        action,
+        build_path_constraint(arg1_expr, arg2_expr, comparison_operator),
+        sym_cond_holds(comparison_operator, arg1, arg2, bits), pc);
+}
+
+void HELPER(sym_brcond_i32)(uint64_t pc,
+                            uint32_t arg1, void *arg1_expr,
+                            uint32_t arg2, void *arg2_expr,
+                            int32_t comparison_operator)
+{
+    sym_brcond_internal(pc, arg1, arg1_expr, arg2, arg2_expr,
+                        comparison_operator, 32);
+}
+
+void HELPER(sym_brcond_i64)(uint64_t pc,
+                            uint64_t arg1, void *arg1_expr,
+                            uint64_t arg2, void *arg2_expr,
+                            int32_t comparison_operator)
+{
+    sym_brcond_internal(pc, arg1, arg1_expr, arg2, arg2_expr,
+                        comparison_operator, 64);
+}
+
+static void *sym_movcond_internal(uint64_t pc,
                               uint64_t c1, void *c1_expr,
                               uint64_t c2, void *c2_expr,
                               uint64_t v1, void *v1_expr,
@@ -605,19 +782,19 @@ static void *sym_movcond_internal(CPUArchState *env,
     }
 
     if (c1_expr == NULL) {
-        c1_expr = _sym_build_integer(c1, _sym_bits_helper(c2_expr));
+        c1_expr = sym_build_constant(c1, _sym_bits_helper(c2_expr));
     }
 
     if (c2_expr == NULL) {
-        c2_expr = _sym_build_integer(c2, _sym_bits_helper(c1_expr));
+        c2_expr = sym_build_constant(c2, _sym_bits_helper(c1_expr));
     }
 
     if (v1_expr == NULL) {
-        v1_expr = _sym_build_integer(v1, _sym_bits_helper(c1_expr));
+        v1_expr = sym_build_constant(v1, _sym_bits_helper(c1_expr));
     }
 
     if (v2_expr == NULL) {
-        v2_expr = _sym_build_integer(v2, _sym_bits_helper(c1_expr));
+        v2_expr = sym_build_constant(v2, _sym_bits_helper(c1_expr));
     }
 
     assert(_sym_bits_helper(c1_expr) == result_bits);
@@ -625,7 +802,7 @@ static void *sym_movcond_internal(CPUArchState *env,
     assert(_sym_bits_helper(v1_expr) == result_bits);
     assert(_sym_bits_helper(v2_expr) == result_bits);
 
-    void *condition_symbol = build_and_push_path_constraint(env, c1_expr, c2_expr, comparison_operator, is_taken);
+    void *condition_symbol = build_and_push_path_constraint(pc, c1_expr, c2_expr, comparison_operator, is_taken);
 
     void *condition_ext = _sym_build_sext(_sym_build_bool_to_bit(condition_symbol),
                                           result_bits - 1);
@@ -638,7 +815,7 @@ static void *sym_movcond_internal(CPUArchState *env,
     return _sym_build_xor(v1_masked, v2_masked);
 }
 
-void *HELPER(sym_movcond_i32)(CPUArchState *env,
+void *HELPER(sym_movcond_i32)(uint64_t pc,
                               uint32_t c1, void *c1_expr,
                               uint32_t c2, void *c2_expr,
                               uint32_t v1, void *v1_expr,
@@ -647,10 +824,10 @@ void *HELPER(sym_movcond_i32)(CPUArchState *env,
                               uint32_t is_taken)
 {
     return sym_movcond_internal(
-            env, c1, c1_expr, c2, c2_expr,v1, v1_expr, v2, v2_expr, comparison_operator, is_taken, 32);
+            pc, c1, c1_expr, c2, c2_expr,v1, v1_expr, v2, v2_expr, comparison_operator, is_taken, 32);
 }
 
-void *HELPER(sym_movcond_i64)(CPUArchState *env,
+void *HELPER(sym_movcond_i64)(uint64_t pc,
                               uint64_t c1, void *c1_expr,
                               uint64_t c2, void *c2_expr,
                               uint64_t v1, void *v1_expr,
@@ -659,7 +836,7 @@ void *HELPER(sym_movcond_i64)(CPUArchState *env,
                               uint64_t is_taken)
 {
     return sym_movcond_internal(
-            env, c1, c1_expr, c2, c2_expr,v1, v1_expr, v2, v2_expr, comparison_operator, is_taken, 64);
+            pc, c1, c1_expr, c2, c2_expr,v1, v1_expr, v2, v2_expr, comparison_operator, is_taken, 64);
 }
 
 
@@ -673,9 +850,32 @@ void HELPER(sym_notify_return)(uint64_t return_address)
     _sym_notify_ret(return_address);
 }
 
-void HELPER(sym_notify_block)(uint64_t block_id)
+uint64_t HELPER(sym_tb_pc_delta)(CPUArchState *env, uint64_t pc_first)
 {
-    _sym_notify_basic_block(block_id);
+    CPUState *cpu = env_cpu(env);
+
+    return cpu->cc->get_pc(cpu) - pc_first;
+}
+
+void HELPER(sym_fork_server)(CPUArchState *env)
+{
+#ifdef CONFIG_LINUX_USER
+    if (sym_fork_server_pc != -1) {
+        sym_fork_server_pc = -1;
+        sym_fork_server_run(env_cpu(env));
+    }
+#else
+    g_assert_not_reached();
+#endif
+}
+
+void HELPER(sym_persistent_end)(CPUArchState *env)
+{
+#ifdef CONFIG_LINUX_USER
+    sym_persistent_end(env_cpu(env));
+#else
+    g_assert_not_reached();
+#endif
 }
 
 void HELPER(sym_collect_garbage)(void)
@@ -683,3 +883,170 @@ void HELPER(sym_collect_garbage)(void)
     _sym_collect_garbage();
 }
 
+/*
+ * Typed entry points for helper_sym_run_program: one wrapper per helper, which
+ * converts the argument words of a program entry to the parameter types of the
+ * helper. Helpers with more arguments than a program entry holds get none.
+ */
+
+#define SYM_PROGRAM_ARG_i32(t, x)   ((dh_ctype(t))(x))
+#define SYM_PROGRAM_ARG_i64(t, x)   ((dh_ctype(t))(x))
+#define SYM_PROGRAM_ARG_ptr(t, x)   ((dh_ctype(t))(uintptr_t)(x))
+#define SYM_PROGRAM_ARG(t, n)       glue(SYM_PROGRAM_ARG_, dh_alias(t))(t, a[n])
+
+#define SYM_PROGRAM_RET_void(x)     ((x), 0)
+#define SYM_PROGRAM_RET_i32(x)      (x)
+#define SYM_PROGRAM_RET_i64(x)      (x)
+#define SYM_PROGRAM_RET_ptr(x)      ((uintptr_t)(x))
+#define SYM_PROGRAM_RET(t, x)       glue(SYM_PROGRAM_RET_, dh_alias(t))(x)
+
+#define SYM_PROGRAM_CALL(NAME, RET, ...)                                \
+    static uint64_t glue(sym_program_, NAME)(const uint64_t *a)         \
+    {                                                                   \
+        return SYM_PROGRAM_RET(RET, HELPER(NAME)(__VA_ARGS__));         \
+    }
+
+#define DEF_HELPER_FLAGS_0(NAME, FLAGS, RET)                            \
+    SYM_PROGRAM_CALL(NAME, RET)
+#define DEF_HELPER_FLAGS_1(NAME, FLAGS, RET, T1)                        \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0))
+#define DEF_HELPER_FLAGS_2(NAME, FLAGS, RET, T1, T2)                    \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1))
+#define DEF_HELPER_FLAGS_3(NAME, FLAGS, RET, T1, T2, T3)                \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1), SYM_PROGRAM_ARG(T3, 2))
+#define DEF_HELPER_FLAGS_4(NAME, FLAGS, RET, T1, T2, T3, T4)            \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1), SYM_PROGRAM_ARG(T3, 2),    \
+                     SYM_PROGRAM_ARG(T4, 3))
+#define DEF_HELPER_FLAGS_5(NAME, FLAGS, RET, T1, T2, T3, T4, T5)        \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1), SYM_PROGRAM_ARG(T3, 2),    \
+                     SYM_PROGRAM_ARG(T4, 3), SYM_PROGRAM_ARG(T5, 4))
+#define DEF_HELPER_FLAGS_6(NAME, FLAGS, RET, T1, T2, T3, T4, T5, T6)    \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1), SYM_PROGRAM_ARG(T3, 2),    \
+                     SYM_PROGRAM_ARG(T4, 3), SYM_PROGRAM_ARG(T5, 4),    \
+                     SYM_PROGRAM_ARG(T6, 5))
+#define DEF_HELPER_FLAGS_7(NAME, FLAGS, RET, T1, T2, T3, T4, T5, T6, T7) \
+    SYM_PROGRAM_CALL(NAME, RET, SYM_PROGRAM_ARG(T1, 0),                 \
+                     SYM_PROGRAM_ARG(T2, 1), SYM_PROGRAM_ARG(T3, 2),    \
+                     SYM_PROGRAM_ARG(T4, 3), SYM_PROGRAM_ARG(T5, 4),    \
+                     SYM_PROGRAM_ARG(T6, 5), SYM_PROGRAM_ARG(T7, 6))
+#define DEF_HELPER_FLAGS_8(NAME, FLAGS, RET, ...)
+#define DEF_HELPER_FLAGS_9(NAME, FLAGS, RET, ...)
+#define DEF_HELPER_FLAGS_10(NAME, FLAGS, RET, ...)
+#define DEF_HELPER_FLAGS_11(NAME, FLAGS, RET, ...)
+
+#include "accel/tcg/tcg-runtime-sym.h"
+
+#undef DEF_HELPER_FLAGS_0
+#undef DEF_HELPER_FLAGS_1
+#undef DEF_HELPER_FLAGS_2
+#undef DEF_HELPER_FLAGS_3
+#undef DEF_HELPER_FLAGS_4
+#undef DEF_HELPER_FLAGS_5
+#undef DEF_HELPER_FLAGS_6
+#undef DEF_HELPER_FLAGS_7
+
+#define SYM_PROGRAM_ENTRY(NAME)                                         \
+    { &glue(helper_info_, NAME), glue(sym_program_, NAME) },
+
+#define DEF_HELPER_FLAGS_0(NAME, FLAGS, RET) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_1(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_2(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_3(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_4(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_5(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_6(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+#define DEF_HELPER_FLAGS_7(NAME, FLAGS, RET, ...) \
+    SYM_PROGRAM_ENTRY(NAME)
+
+static const struct {
+    const TCGHelperInfo *info;
+    SymProgramCall call;
+} sym_program_calls[] = {
+#include "accel/tcg/tcg-runtime-sym.h"
+};
+
+#undef DEF_HELPER_FLAGS_0
+#undef DEF_HELPER_FLAGS_1
+#undef DEF_HELPER_FLAGS_2
+#undef DEF_HELPER_FLAGS_3
+#undef DEF_HELPER_FLAGS_4
+#undef DEF_HELPER_FLAGS_5
+#undef DEF_HELPER_FLAGS_6
+#undef DEF_HELPER_FLAGS_7
+#undef DEF_HELPER_FLAGS_8
+#undef DEF_HELPER_FLAGS_9
+#undef DEF_HELPER_FLAGS_10
+#undef DEF_HELPER_FLAGS_11
+
+SymProgramCall sym_program_call(const TCGHelperInfo *info)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(sym_program_calls); i++) {
+        if (sym_program_calls[i].info == info) {
+            return sym_program_calls[i].call;
+        }
+    }
+    return NULL;
+}
+
+void HELPER(sym_run_program)(CPUArchState *env, const void *program)
+{
+    const SymProgram *prog = program;
+    uint64_t *slots = env_cpu(env)->neg.sym_slots;
+    uint64_t results[SYM_PROGRAM_MAX_ENTRIES];
+    uint64_t a[SYM_PROGRAM_MAX_ARGS];
+    bool concrete = true;
+    int i, j;
+
+    for (i = 0; i < prog->nb_inputs; i++) {
+        if (slots[prog->inputs[i]] != 0) {
+            concrete = false;
+            break;
+        }
+    }
+    if (concrete) {
+        /* All helpers of the run map concrete inputs to a concrete result. */
+        for (i = 0; i < prog->nb_entries; i++) {
+            slots[prog->entries[i].result_slot] = 0;
+        }
+        return;
+    }
+
+    for (i = 0; i < prog->nb_entries; i++) {
+        const SymProgramEntry *entry = &prog->entries[i];
+        bool has_expr = false;
+
+        for (j = 0; j < entry->nb_args; j++) {
+            const SymProgramArg *arg = &entry->args[j];
+            uint64_t val;
+
+            switch (arg->kind) {
+            case SYM_PROGRAM_ARG_SLOT:
+                val = slots[arg->val];
+                break;
+            case SYM_PROGRAM_ARG_RESULT:
+                val = results[arg->val];
+                break;
+            default:
+                val = arg->val;
+                break;
+            }
+            a[j] = val;
+            has_expr |= arg->is_expr && val != 0;
+        }
+
+        results[i] = has_expr ? entry->call(a) : 0;
+        slots[entry->result_slot] = results[i];
+    }
+}
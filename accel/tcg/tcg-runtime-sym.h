@@ -33,9 +33,9 @@
  * with the corresponding symbolic expressions, and returning a symbolic
  * expression. This covers a lot of instructions (e.g., add, sub, mul, div). */
 #define SYM_HELPER_BINARY(name)                                         \
-  DEF_HELPER_FLAGS_4(sym_##name##_i32, TCG_CALL_NO_RWG_SE, ptr,                \
+  DEF_HELPER_FLAGS_4(sym_##name##_i32, TCG_CALL_SYM_NO_RWG_SE, ptr,            \
                      i32, ptr, i32, ptr)                                       \
-  DEF_HELPER_FLAGS_4(sym_##name##_i64, TCG_CALL_NO_RWG_SE, ptr,                \
+  DEF_HELPER_FLAGS_4(sym_##name##_i64, TCG_CALL_SYM_NO_RWG_SE, ptr,            \
                      i64, ptr, i64, ptr)
 
 /* Arithmetic */
@@ -46,7 +46,7 @@ SYM_HELPER_BINARY(div)
 SYM_HELPER_BINARY(divu)
 SYM_HELPER_BINARY(rem)
 SYM_HELPER_BINARY(remu)
-DEF_HELPER_FLAGS_1(sym_neg, TCG_CALL_NO_RWG_SE, ptr, ptr)
+DEF_HELPER_FLAGS_1(sym_neg, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr)
 
 /* Shifts */
 SYM_HELPER_BINARY(shift_right)
@@ -64,7 +64,7 @@ SYM_HELPER_BINARY(eqv)
 SYM_HELPER_BINARY(nand)
 SYM_HELPER_BINARY(nor)
 SYM_HELPER_BINARY(orc)
-DEF_HELPER_FLAGS_1(sym_not, TCG_CALL_NO_RWG_SE, ptr, ptr)
+DEF_HELPER_FLAGS_1(sym_not, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr)
 
 #undef SYM_HELPER_BINARY
 
@@ -74,56 +74,69 @@ DEF_HELPER_FLAGS_1(sym_not, TCG_CALL_NO_RWG_SE, ptr, ptr)
  * work around problems related to the large number of inputs and outputs
  * required by multi-word arithmetic. Multiplication, however, needs a
  * helper. */
-DEF_HELPER_FLAGS_4(sym_muluh_i64, TCG_CALL_NO_RWG_SE, ptr, i64, ptr, i64, ptr)
+DEF_HELPER_FLAGS_4(sym_muluh_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, i64, ptr, i64, ptr)
 
 /* Extension and truncation */
-DEF_HELPER_FLAGS_2(sym_sext, TCG_CALL_NO_RWG_SE, ptr, ptr, i64)
-DEF_HELPER_FLAGS_2(sym_zext, TCG_CALL_NO_RWG_SE, ptr, ptr, i64)
-DEF_HELPER_FLAGS_1(sym_sext_i32_i64, TCG_CALL_NO_RWG_SE, ptr, ptr)
-DEF_HELPER_FLAGS_1(sym_zext_i32_i64, TCG_CALL_NO_RWG_SE, ptr, ptr)
-DEF_HELPER_FLAGS_1(sym_trunc_i64_i32, TCG_CALL_NO_RWG_SE, ptr, ptr)
+DEF_HELPER_FLAGS_2(sym_sext, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i64)
+DEF_HELPER_FLAGS_2(sym_zext, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i64)
+DEF_HELPER_FLAGS_1(sym_sext_i32_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr)
+DEF_HELPER_FLAGS_1(sym_zext_i32_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr)
+DEF_HELPER_FLAGS_1(sym_trunc_i64_i32, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr)
 
 /* Byte swapping */
-DEF_HELPER_FLAGS_2(sym_bswap, TCG_CALL_NO_RWG_SE, ptr, ptr, i64)
+DEF_HELPER_FLAGS_2(sym_bswap, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i64)
 
 /* Guest memory */
-DEF_HELPER_FLAGS_5(sym_load_guest_i32, TCG_CALL_NO_RWG, ptr, env, i64, ptr, i64, i64)
-DEF_HELPER_FLAGS_5(sym_load_guest_i64, TCG_CALL_NO_RWG, ptr, env, i64, ptr, i64, i64)
-DEF_HELPER_FLAGS_7(sym_store_guest_i32, TCG_CALL_NO_RWG, void, env, i32, ptr,
-                   i64, ptr, i64, i64)
-DEF_HELPER_FLAGS_7(sym_store_guest_i64, TCG_CALL_NO_RWG, void, env, i64, ptr,
-                   i64, ptr, i64, i64)
+DEF_HELPER_FLAGS_6(sym_load_guest_i32, TCG_CALL_SYM_DROP_NO_RWG, ptr, env, i64, ptr, i64, i64, i64)
+DEF_HELPER_FLAGS_6(sym_load_guest_i64, TCG_CALL_SYM_DROP_NO_RWG, ptr, env, i64, ptr, i64, i64, i64)
+DEF_HELPER_FLAGS_8(sym_store_guest_i32, TCG_CALL_NO_RWG, void, env, i32, ptr,
+                   i64, ptr, i64, i64, i64)
+DEF_HELPER_FLAGS_8(sym_store_guest_i64, TCG_CALL_NO_RWG, void, env, i64, ptr,
+                   i64, ptr, i64, i64, i64)
+DEF_HELPER_FLAGS_4(sym_check_concrete_load, TCG_CALL_NO_RWG, void, env, i64,
+                   i64, i64)
+DEF_HELPER_FLAGS_3(sym_address_constraint, TCG_CALL_SYM_DROP_NO_RWG, void, i64, i64, ptr)
 
 /* Host memory */
-DEF_HELPER_FLAGS_3(sym_load_host_i32, TCG_CALL_NO_RWG_SE, ptr, ptr, i64, i64)
-DEF_HELPER_FLAGS_3(sym_load_host_i64, TCG_CALL_NO_RWG_SE, ptr, ptr, i64, i64)
-DEF_HELPER_FLAGS_3(sym_load_host_vec, TCG_CALL_NO_RWG_SE, ptr, ptr, i64, i64)
+DEF_HELPER_FLAGS_3(sym_load_host_i32, TCG_CALL_SYM_DROP_NO_RWG_SE, ptr, ptr, i64, i64)
+DEF_HELPER_FLAGS_3(sym_load_host_i64, TCG_CALL_SYM_DROP_NO_RWG_SE, ptr, ptr, i64, i64)
+DEF_HELPER_FLAGS_3(sym_load_host_vec, TCG_CALL_SYM_DROP_NO_RWG_SE, ptr, ptr, i64, i64)
 DEF_HELPER_FLAGS_4(sym_store_host, TCG_CALL_NO_RWG, void, ptr, ptr,
                    i64, i64)
 
 /* Bit fields */
-DEF_HELPER_FLAGS_3(sym_extract_i32, TCG_CALL_NO_RWG_SE, ptr, ptr, i32, i32)
-DEF_HELPER_FLAGS_3(sym_extract_i64, TCG_CALL_NO_RWG_SE, ptr, ptr, i64, i64)
-DEF_HELPER_FLAGS_3(sym_sextract_i32, TCG_CALL_NO_RWG_SE, ptr, ptr, i32, i32)
-DEF_HELPER_FLAGS_3(sym_sextract_i64, TCG_CALL_NO_RWG_SE, ptr, ptr, i64, i64)
-DEF_HELPER_FLAGS_5(sym_extract2_i32, TCG_CALL_NO_RWG_SE, ptr, i32, ptr, i32, ptr, i64)
-DEF_HELPER_FLAGS_5(sym_extract2_i64, TCG_CALL_NO_RWG_SE, ptr, i64, ptr, i64, ptr, i64)
-DEF_HELPER_FLAGS_6(sym_deposit_i32, TCG_CALL_NO_RWG_SE, ptr, i32, ptr, i32, ptr, i32, i32)
-DEF_HELPER_FLAGS_6(sym_deposit_i64, TCG_CALL_NO_RWG_SE, ptr, i64, ptr, i64, ptr, i64, i64)
+DEF_HELPER_FLAGS_3(sym_extract_i32, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i32, i32)
+DEF_HELPER_FLAGS_3(sym_extract_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i64, i64)
+DEF_HELPER_FLAGS_3(sym_sextract_i32, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i32, i32)
+DEF_HELPER_FLAGS_3(sym_sextract_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, ptr, i64, i64)
+DEF_HELPER_FLAGS_5(sym_extract2_i32, TCG_CALL_SYM_NO_RWG_SE, ptr, i32, ptr, i32, ptr, i64)
+DEF_HELPER_FLAGS_5(sym_extract2_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, i64, ptr, i64, ptr, i64)
+DEF_HELPER_FLAGS_6(sym_deposit_i32, TCG_CALL_SYM_NO_RWG_SE, ptr, i32, ptr, i32, ptr, i32, i32)
+DEF_HELPER_FLAGS_6(sym_deposit_i64, TCG_CALL_SYM_NO_RWG_SE, ptr, i64, ptr, i64, ptr, i64, i64)
 
 /* Conditionals */
-DEF_HELPER_FLAGS_7(sym_setcond_i32, TCG_CALL_NO_RWG, ptr, env, i32, ptr, i32, ptr, s32, i32)
-DEF_HELPER_FLAGS_7(sym_setcond_i64, TCG_CALL_NO_RWG, ptr, env, i64, ptr, i64, ptr, s32, i64)
-DEF_HELPER_FLAGS_11(sym_movcond_i32, TCG_CALL_NO_RWG, ptr, env, i32, ptr, i32, ptr, i32, ptr, i32, ptr, s32, i32)
-DEF_HELPER_FLAGS_11(sym_movcond_i64, TCG_CALL_NO_RWG, ptr, env, i64, ptr, i64, ptr, i64, ptr, i64, ptr, s32, i64)
+DEF_HELPER_FLAGS_7(sym_setcond_i32, TCG_CALL_SYM_NO_RWG, ptr, i64, i32, ptr, i32, ptr, s32, i32)
+DEF_HELPER_FLAGS_7(sym_setcond_i64, TCG_CALL_SYM_NO_RWG, ptr, i64, i64, ptr, i64, ptr, s32, i64)
+DEF_HELPER_FLAGS_11(sym_movcond_i32, TCG_CALL_SYM_NO_RWG, ptr, i64, i32, ptr, i32, ptr, i32, ptr, i32, ptr, s32, i32)
+DEF_HELPER_FLAGS_11(sym_movcond_i64, TCG_CALL_SYM_NO_RWG, ptr, i64, i64, ptr, i64, ptr, i64, ptr, i64, ptr, s32, i64)
+
+DEF_HELPER_FLAGS_6(sym_brcond_i32, TCG_CALL_SYM_NO_RWG, void, i64, i32, ptr, i32, ptr, s32)
+DEF_HELPER_FLAGS_6(sym_brcond_i64, TCG_CALL_SYM_NO_RWG, void, i64, i64, ptr, i64, ptr, s32)
 
 /* Context tracking */
 DEF_HELPER_FLAGS_1(sym_notify_call, TCG_CALL_NO_RWG, void, i64)
 DEF_HELPER_FLAGS_1(sym_notify_return, TCG_CALL_NO_RWG, void, i64)
-DEF_HELPER_FLAGS_1(sym_notify_block, TCG_CALL_NO_RWG, void, i64)
+DEF_HELPER_FLAGS_2(sym_tb_pc_delta, TCG_CALL_NO_WG_SE, i64, env, i64)
+
+/* Fork server */
+DEF_HELPER_FLAGS_1(sym_fork_server, TCG_CALL_NO_WG, void, env)
+DEF_HELPER_FLAGS_1(sym_persistent_end, TCG_CALL_NO_WG, void, env)
 
 /* Garbage collection */
-DEF_HELPER_FLAGS_0(sym_collect_garbage, TCG_CALL_NO_RWG, void)
+DEF_HELPER_FLAGS_0(sym_collect_garbage, TCG_CALL_SYM_DROP_NO_RWG, void)
+
+/* Fused runs of helper calls (see include/tcg/sym-program.h) */
+DEF_HELPER_FLAGS_2(sym_run_program, TCG_CALL_SYM_DROP_NO_RWG, void, env, cptr)
 
 /* TODO clz, ctz, clrsb, ctpop; vector operations; helpers for atomic operations (?) */
 
@@ -65,6 +65,7 @@
 #include "internal-target.h"
 #include "tcg/perf.h"
 #include "tcg/insn-start-words.h"
+#include "tcg/sym-fork-server.h"
 
 TBContext tb_ctx;
 
@@ -558,6 +559,9 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
         tcg_tb_remove(tb);
         return existing_tb;
     }
+#ifdef CONFIG_LINUX_USER
+    sym_fork_server_notify_tb(pc, cs_base, flags, cflags);
+#endif
     return tb;
 }
 
@@ -16,6 +16,7 @@
 #include "exec/plugin-gen.h"
 #include "exec/cpu_ldst.h"
 #include "tcg/tcg-op-common.h"
+#include "tcg/sym-fork-server.h"
 #include "internal-target.h"
 #include "disas/disas.h"
 
@@ -81,9 +82,25 @@ static TCGOp *gen_tb_start(DisasContextBase *db, uint32_t cflags)
                          - offsetof(ArchCPU, env));
     }
 
-    TCGv_i64 block = tcg_constant_i64((int64_t) db->tb);
-    gen_helper_sym_notify_block(block);
-    // tcg_temp_free_i64(block); TODO: free is reserved for internal now, is it ok in that case?
+#ifdef CONFIG_LINUX_USER
+    if (db->pc_first == sym_fork_server_pc) {
+        gen_helper_sym_fork_server(tcg_env);
+    }
+    if (db->pc_first == sym_persistent_end_pc) {
+        gen_helper_sym_persistent_end(tcg_env);
+    }
+#endif
+    /*
+     * Constraint sites are guest PCs, but a PC-relative TB may be entered
+     * at any virtual address mapping its code; relocate them at run time.
+     */
+    if ((cflags & CF_PCREL) && !tcg_ctx->sym_concrete_tb) {
+        tcg_ctx->sym_pc_delta = tcg_temp_new_i64();
+        tcg_ctx->sym_pc = tcg_temp_new_i64();
+        gen_helper_sym_tb_pc_delta(tcg_ctx->sym_pc_delta, tcg_env,
+                                   tcg_constant_i64(db->pc_first));
+    }
+    tcg_gen_sym_notify_block(db->pc_first);
 
     return icount_start_insn;
 }
@@ -141,6 +158,11 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     db->record_start = 0;
     db->record_len = 0;
 
+    /* Drop the symbolic instrumentation in concrete clones of TBs. */
+    tcg_ctx->sym_concrete_tb = cflags & CF_SYM_CONCRETE;
+    tcg_ctx->sym_insn_pc = db->pc_first;
+    tcg_ctx->sym_pc_delta = NULL;
+
     ops->init_disas_context(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
 
@@ -154,6 +176,7 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
 
     while (true) {
         *max_insns = ++db->num_insns;
+        tcg_ctx->sym_insn_pc = db->pc_next;
         ops->insn_start(db, cpu);
         db->insn_start = tcg_last_op();
         if (first_insn_start == NULL) {
@@ -197,6 +220,15 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
             db->is_jmp = DISAS_TOO_MANY;
             break;
         }
+
+#ifdef CONFIG_LINUX_USER
+        /* The fork server and persistent runs start and end TBs. */
+        if (db->pc_next == sym_fork_server_pc ||
+            db->pc_next == sym_persistent_end_pc) {
+            db->is_jmp = DISAS_TOO_MANY;
+            break;
+        }
+#endif
     }
 
     /* Emit code to exit the TB, as indicated by db->is_jmp.  */
@@ -345,13 +345,36 @@ typedef union IcountDecr {
     } u16;
 } IcountDecr;
 
+/* Number of scratch slots for SymQEMU expression programs */
+#define SYM_PROGRAM_NB_SLOTS 64
+
+/* Vector operands spilled for SymQEMU's vector helpers (one V256 each) */
+#define SYM_VEC_SCRATCH_SLOTS     16
+#define SYM_VEC_SCRATCH_SLOT_SIZE 32
+
+/* Number of TB exits between two garbage collection checks of SymQEMU */
+#define SYM_GC_INTERVAL 1024
+
 /**
  * CPUNegativeOffsetState: Elements of CPUState most efficiently accessed
  *                         from CPUArchState, via small negative offsets.
+ * @sym_slots: operands and results of SymQEMU expression programs; kept
+ *             first so that the offsets of the other fields don't change.
+ * @sym_vec_scratch: concrete vector operands passed to SymQEMU's vector
+ *                   helpers (see store_vector_in_memory).
+ * @sym_gc_countdown: TB exits left until SymQEMU's next garbage collection
+ *                    check (see gen_sym_collect_garbage).
+ * @sym_block_pc: guest PC of the current TB until SymQEMU's runtime has
+ *                passed it to the backend, 0 afterwards
+ *                (see tcg_gen_sym_notify_block).
  * @can_do_io: True if memory-mapped IO is allowed.
  * @plugin_mem_cbs: active plugin memory callbacks
  */
 typedef struct CPUNegativeOffsetState {
+    uint64_t sym_slots[SYM_PROGRAM_NB_SLOTS];
+    uint8_t sym_vec_scratch[SYM_VEC_SCRATCH_SLOTS][SYM_VEC_SCRATCH_SLOT_SIZE];
+    int32_t sym_gc_countdown;
+    uint64_t sym_block_pc;
     CPUTLB tlb;
 #ifdef CONFIG_PLUGIN
     /*
@@ -484,6 +507,11 @@ struct CPUState {
     bool exit_request;
     int exclusive_context_count;
     uint32_t cflags_next_tb;
+    /* SymQEMU dual translation, see sym_select_variant() in cpu-exec.c */
+    bool sym_force_instrumented;
+    bool sym_env_dirty;
+    uint32_t sym_env_rescan;
+    unsigned long *sym_env_words;
     /* updates protected by BQL */
     uint32_t interrupt_request;
     int singlestep_enabled;
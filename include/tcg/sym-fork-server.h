@@ -0,0 +1,63 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AFL-compatible fork server (linux-user only)
+ *
+ * With -sym-fork-server, the TB that starts at sym_fork_server_pc calls
+ * helper_sym_fork_server when it first runs. If a fuzzer listens on the AFL
+ * control descriptors, the emulator then stays there and forks one child per
+ * request, each of which continues from that point with the binary loaded,
+ * the dynamic loader done, the symbolic runtime initialized and all the code
+ * translated so far. Children report the TBs that they translate on a pipe,
+ * and the server translates them as well, so that later children inherit
+ * them too (see accel/tcg/sym-fork-server.c).
+ *
+ * With -sym-persistent, a child runs the guest from sym_fork_server_pc to
+ * sym_persistent_end_pc and exits there. Each run takes a fresh child, since
+ * the backend's path constraints cannot be reset between runs.
+ *
+ * With -sym-batch, the server takes its requests from sym_batch_source, a
+ * directory of inputs or a file (typically a FIFO) with one input path per
+ * line, and exits at its end.
+ */
+
+#ifndef TCG_SYM_FORK_SERVER_H
+#define TCG_SYM_FORK_SERVER_H
+
+#include "exec/vaddr.h"
+
+/* File descriptors of the AFL fork server protocol */
+#define SYM_FORKSRV_FD      198
+#define SYM_FORKSRV_ST_FD   (SYM_FORKSRV_FD + 1)
+
+/* Where the fork server starts; -1 when disabled or already started. */
+extern vaddr sym_fork_server_pc;
+
+/* Where a persistent run ends; -1 when not in persistent mode. */
+extern vaddr sym_persistent_end_pc;
+
+/* Where batch mode reads its inputs from; NULL for an AFL fork server */
+extern const char *sym_batch_source;
+
+void sym_fork_server_run(CPUState *cpu);
+void sym_fork_server_notify_tb(vaddr pc, uint64_t cs_base,
+                               uint32_t flags, uint32_t cflags);
+void sym_fork_server_fork_end(bool child);
+
+void sym_persistent_end(CPUState *cpu);
+
+#endif /* TCG_SYM_FORK_SERVER_H */
@@ -0,0 +1,80 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Map of the guest pages that may hold symbolic data
+ *
+ * The map has one byte per 4 KiB slot of guest virtual addresses; a slot is
+ * set before symbolic data is first written to guest memory in it, and it is
+ * never cleared. Addresses beyond the range of the map wrap around, which
+ * only makes it more conservative. In user mode, with sym-fast-path, guest
+ * memory accesses test the slot inline and don't call the symbolic helper for
+ * concrete addresses into clean slots (see
+ * tcg_gen_sym_memory_fast_path_begin); stores of concrete values into clean
+ * slots don't touch the shadow memory at all, since there is no symbolic data
+ * to overwrite.
+ *
+ * Accesses only test the slot of their first byte, so marking a range also
+ * marks the slot in front of it: an access that starts there and crosses
+ * into the range is then caught as well.
+ *
+ * In user mode, the slots of a mapping of the input file hold
+ * SYM_PAGE_MAP_INPUT until the input there is symbolized: the helpers that
+ * access guest memory check the slots of both ends of the access and call
+ * sym_input_map_touch first (see linux-user/mmap.c).
+ */
+
+#ifndef TCG_SYM_PAGE_MAP_H
+#define TCG_SYM_PAGE_MAP_H
+
+#define SYM_PAGE_BITS       12
+#define SYM_PAGE_MAP_BITS   20
+#define SYM_PAGE_MAP_SIZE   (1 << SYM_PAGE_MAP_BITS)
+#define SYM_PAGE_MAP_INPUT  2
+
+extern uint8_t sym_page_map[SYM_PAGE_MAP_SIZE];
+
+static inline uint64_t sym_page_map_index(uint64_t addr)
+{
+    return (addr >> SYM_PAGE_BITS) & (SYM_PAGE_MAP_SIZE - 1);
+}
+
+static inline bool sym_page_map_test(uint64_t addr)
+{
+    return sym_page_map[sym_page_map_index(addr)] != 0;
+}
+
+static inline void sym_page_map_mark(uint64_t addr, uint64_t length)
+{
+    uint64_t first = (addr >> SYM_PAGE_BITS) - 1;
+    uint64_t last = (addr + length - 1) >> SYM_PAGE_BITS;
+
+    if (length == 0) {
+        return;
+    }
+    for (uint64_t i = 0; i <= last - first && i < SYM_PAGE_MAP_SIZE; i++) {
+        uint8_t *slot = &sym_page_map[(first + i) & (SYM_PAGE_MAP_SIZE - 1)];
+
+        /* Only write on the first mark, to keep the cache line shared. */
+        if (*slot == 0) {
+            *slot = 1;
+        }
+    }
+}
+
+void sym_input_map_touch(uint64_t addr, uint64_t length);
+
+#endif /* TCG_SYM_PAGE_MAP_H */
@@ -0,0 +1,76 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Symbolic expression programs
+ *
+ * With sym-fuse, tcg/sym-program.c replaces runs of calls to pure symbolic
+ * helpers within a TB by a single call to helper_sym_run_program, which
+ * interprets a compact description of the run. The concrete operands and the
+ * incoming expressions of the run are stored inline into the per-vCPU slots
+ * (CPUNegativeOffsetState.sym_slots) at the position of the original calls;
+ * the interpreter leaves the result of each entry in a slot, from where it is
+ * loaded back into the expression temps after the call.
+ *
+ * Programs are allocated at the end of the code region of their TB (see
+ * tcg_region_data_alloc), so they are reclaimed together with the code.
+ */
+
+#ifndef TCG_SYM_PROGRAM_H
+#define TCG_SYM_PROGRAM_H
+
+#include "hw/core/cpu.h"
+
+#define SYM_PROGRAM_MAX_ARGS    7
+#define SYM_PROGRAM_MAX_ENTRIES 32
+
+typedef enum SymProgramArgKind {
+    SYM_PROGRAM_ARG_CONST,      /* val is the value itself */
+    SYM_PROGRAM_ARG_SLOT,       /* val is the index of a slot */
+    SYM_PROGRAM_ARG_RESULT,     /* val is the index of an earlier entry */
+} SymProgramArgKind;
+
+/*
+ * Calls a symbolic helper with the arguments in @args, each converted to the
+ * type of the corresponding parameter, and returns its result as a word.
+ */
+typedef uint64_t (*SymProgramCall)(const uint64_t *args);
+
+typedef struct SymProgramArg {
+    uint8_t kind;               /* SymProgramArgKind */
+    bool is_expr;
+    uint64_t val;
+} SymProgramArg;
+
+typedef struct SymProgramEntry {
+    SymProgramCall call;
+    uint8_t nb_args;
+    uint8_t result_slot;
+    SymProgramArg args[SYM_PROGRAM_MAX_ARGS];
+} SymProgramEntry;
+
+typedef struct SymProgram {
+    uint8_t nb_entries;
+    uint8_t nb_inputs;
+    /* Slots holding the incoming expressions of the run. */
+    uint8_t inputs[SYM_PROGRAM_NB_SLOTS];
+    SymProgramEntry entries[];
+} SymProgram;
+
+/* The typed entry point of a symbolic helper, or NULL if there is none. */
+SymProgramCall sym_program_call(const TCGHelperInfo *info);
+
+#endif /* TCG_SYM_PROGRAM_H */
@@ -18,13 +18,100 @@
  * SYM_HELPER_BINARY_64 generates the analogous code for 64-bit helpers. */
 
 #define SYM_HELPER_BINARY_32(name)                                              \
-    gen_helper_sym_ ## name ## _i32(tcgv_i32_expr(ret),                         \
-                           arg1, tcgv_i32_expr(arg1),                           \
-                           arg2, tcgv_i32_expr(arg2))
+    do {                                                                        \
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(                         \
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg1), tcgv_i32_expr(arg2));      \
+        gen_helper_sym_ ## name ## _i32(tcgv_i32_expr(ret),                     \
+                               arg1, tcgv_i32_expr(arg1),                       \
+                               arg2, tcgv_i32_expr(arg2));                      \
+        tcg_gen_sym_fast_path_end(sym_skip);                                    \
+    } while (0)
 #define SYM_HELPER_BINARY_64(name)                                              \
-    gen_helper_sym_ ## name ## _i64(tcgv_i64_expr(ret),                         \
-                           arg1, tcgv_i64_expr(arg1),                           \
-                           arg2, tcgv_i64_expr(arg2))
+    do {                                                                        \
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(                         \
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));      \
+        gen_helper_sym_ ## name ## _i64(tcgv_i64_expr(ret),                     \
+                               arg1, tcgv_i64_expr(arg1),                       \
+                               arg2, tcgv_i64_expr(arg2));                      \
+        tcg_gen_sym_fast_path_end(sym_skip);                                    \
+    } while (0)
+
+/**
+ * tcg_gen_sym_fast_path_begin() - skip a symbolic helper on concrete inputs
+ * @ret_expr: expression temp written by the helper, or NULL
+ * @nb_exprs: number of input expressions
+ * @exprs: input expression temps of the helper
+ *
+ * If the inline concreteness fast path is enabled (see "sym-fast-path"),
+ * emit an inline test of @exprs that branches around the helper call emitted
+ * next when all inputs are NULL. Close the region with
+ * tcg_gen_sym_fast_path_end() right after the call; it sets @ret_expr to NULL
+ * on the skip path only, so @ret_expr may alias one of @exprs.
+ *
+ * Returns the state to pass to tcg_gen_sym_fast_path_end(), or NULL if the
+ * fast path is disabled.
+ */
+typedef struct TCGSymFastPath TCGSymFastPath;
+
+TCGSymFastPath *tcg_gen_sym_fast_path_begin(TCGv_ptr ret_expr, int nb_exprs,
+                                            const TCGv_ptr *exprs);
+void tcg_gen_sym_fast_path_end(TCGSymFastPath *fp);
+
+/**
+ * tcg_gen_sym_memory_fast_path_begin() - skip a symbolic guest memory access
+ * @ret_expr: expression temp written by the helper, or NULL
+ * @addr: guest virtual address of the access
+ * @nb_exprs: number of input expressions
+ * @exprs: input expression temps of the helper
+ *
+ * Like tcg_gen_sym_fast_path_begin(), but the helper is only skipped if, in
+ * addition, the page map says that @addr points into memory without symbolic
+ * data (see include/tcg/sym-page-map.h). Only available in user mode; returns
+ * NULL otherwise.
+ */
+TCGSymFastPath *tcg_gen_sym_memory_fast_path_begin(TCGv_ptr ret_expr,
+                                                   TCGv_i64 addr,
+                                                   int nb_exprs,
+                                                   const TCGv_ptr *exprs);
+
+/**
+ * tcg_gen_sym_notify_block() - record the start of a TB
+ * @pc: guest PC of the TB
+ *
+ * Emit a store of @pc to CPUNegativeOffsetState.sym_block_pc at the start of
+ * a TB. Rather than calling into the backend for every executed block, the
+ * runtime passes the pending block to it right before the next query, so
+ * that only blocks that actually reach the solver cost a call.
+ */
+void tcg_gen_sym_notify_block(uint64_t pc);
+
+/**
+ * tcg_gen_sym_notify_call_i64() - report a guest call to the backend
+ * @ret_addr: return address of the call
+ *
+ * The backend uses calls and returns as the calling context of path
+ * constraints. Both are identified by the return address, so that a return
+ * matches the call that pushed it. Translators use the TCGv variants
+ * tcg_gen_sym_notify_call() and tcg_gen_sym_notify_return().
+ */
+void tcg_gen_sym_notify_call_i32(TCGv_i32 ret_addr);
+void tcg_gen_sym_notify_call_i64(TCGv_i64 ret_addr);
+
+/**
+ * tcg_gen_sym_notify_return_i64() - report a guest return to the backend
+ * @ret_addr: address that the guest returns to
+ *
+ * See tcg_gen_sym_notify_call_i64().
+ */
+void tcg_gen_sym_notify_return_i32(TCGv_i32 ret_addr);
+void tcg_gen_sym_notify_return_i64(TCGv_i64 ret_addr);
+
+/* SYM_FAST_PATH_BEGIN(ret_expr, in1_expr, in2_expr, ...) saves spelling out
+ * the input array for tcg_gen_sym_fast_path_begin. */
+#define SYM_FAST_PATH_BEGIN(ret_expr, ...)                                      \
+    tcg_gen_sym_fast_path_begin(ret_expr,                                       \
+                                ARRAY_SIZE(((TCGv_ptr[]){ __VA_ARGS__ })),      \
+                                (TCGv_ptr[]){ __VA_ARGS__ })
 
 
 TCGv_i32 tcg_constant_i32(int32_t val);
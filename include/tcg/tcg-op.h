@@ -280,6 +280,8 @@ DEF_ATOMIC2(tcg_gen_atomic_umax_fetch, i64)
 #define tcg_gen_dup_tl_vec  tcg_gen_dup_i64_vec
 #define tcg_gen_dup_tl tcg_gen_dup_i64
 #define dup_const_tl dup_const
+#define tcg_gen_sym_notify_call tcg_gen_sym_notify_call_i64
+#define tcg_gen_sym_notify_return tcg_gen_sym_notify_return_i64
 #else
 #define tcg_gen_movi_tl tcg_gen_movi_i32
 #define tcg_gen_mov_tl tcg_gen_mov_i32
@@ -397,6 +399,8 @@ DEF_ATOMIC2(tcg_gen_atomic_umax_fetch, i64)
 #define tcg_gen_atomic_umax_fetch_tl tcg_gen_atomic_umax_fetch_i32
 #define tcg_gen_dup_tl_vec  tcg_gen_dup_i32_vec
 #define tcg_gen_dup_tl tcg_gen_dup_i32
+#define tcg_gen_sym_notify_call tcg_gen_sym_notify_call_i32
+#define tcg_gen_sym_notify_return tcg_gen_sym_notify_return_i32
 
 #define dup_const_tl(VECE, C)                                      \
     (__builtin_constant_p(VECE)                                    \
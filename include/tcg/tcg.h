@@ -354,6 +354,14 @@ typedef TCGv_ptr TCGv_env;
 #define TCG_CALL_NO_SIDE_EFFECTS    0x0004
 /* Helper is G_NORETURN.  */
 #define TCG_CALL_NO_RETURN          0x0008
+/* SymQEMU: symbolic helper that returns a NULL expression, without any other
+   effect, when all of its expression arguments are NULL. All of its pointer
+   arguments must be expressions. */
+#define TCG_CALL_SYM_NULL_PRESERVING 0x0010
+/* SymQEMU: symbolic helper that is left out of the concrete clone of a TB
+   (CF_SYM_CONCRETE), which reads its result expression as NULL. Helpers with
+   TCG_CALL_SYM_NULL_PRESERVING are left out as well. */
+#define TCG_CALL_SYM_CONCRETE_DROP  0x0020
 
 /* convenience version of most used call flags */
 #define TCG_CALL_NO_RWG         TCG_CALL_NO_READ_GLOBALS
@@ -361,6 +369,10 @@ typedef TCGv_ptr TCGv_env;
 #define TCG_CALL_NO_SE          TCG_CALL_NO_SIDE_EFFECTS
 #define TCG_CALL_NO_RWG_SE      (TCG_CALL_NO_RWG | TCG_CALL_NO_SE)
 #define TCG_CALL_NO_WG_SE       (TCG_CALL_NO_WG | TCG_CALL_NO_SE)
+#define TCG_CALL_SYM_NO_RWG     (TCG_CALL_NO_RWG | TCG_CALL_SYM_NULL_PRESERVING)
+#define TCG_CALL_SYM_NO_RWG_SE  (TCG_CALL_NO_RWG_SE | TCG_CALL_SYM_NULL_PRESERVING)
+#define TCG_CALL_SYM_DROP_NO_RWG    (TCG_CALL_NO_RWG | TCG_CALL_SYM_CONCRETE_DROP)
+#define TCG_CALL_SYM_DROP_NO_RWG_SE (TCG_CALL_NO_RWG_SE | TCG_CALL_SYM_CONCRETE_DROP)
 
 /*
  * Flags for the bswap opcodes.
@@ -415,6 +427,9 @@ typedef struct TCGTemp {
     unsigned int temp_subindex_len:1;
     /* If true, this temp contains a symbolic expression. */
     unsigned int symbolic_expression:1;
+    /* If true, this TEMP_TB temp was requested as TEMP_EBB (see
+       tcg_temp_new_internal) and may be recycled when freed. */
+    unsigned int sym_promoted_ebb:1;
 
     int64_t val;
     struct TCGTemp *mem_base;
@@ -536,6 +551,38 @@ struct TCGContext {
 
     TCGLabel *exitreq_label;
 
+    /*
+     * SymQEMU: emit an inline test of the input expressions in front of
+     * symbolic helper calls and branch around them when all inputs are
+     * concrete (see tcg_gen_sym_fast_path_begin).
+     */
+    bool sym_fast_path;
+    /*
+     * SymQEMU: the TB being translated is the concrete clone of a
+     * symbolic TB (CF_SYM_CONCRETE); symbolic helpers are dropped.
+     */
+    bool sym_concrete_tb;
+    /*
+     * SymQEMU: address of the guest instruction being translated; passed
+     * to the helpers that push path constraints as the constraint site.
+     */
+    uint64_t sym_insn_pc;
+    /*
+     * SymQEMU: in position-independent TBs (CF_PCREL), the difference
+     * between the PC that the TB was entered with and the one it was
+     * translated for, and a scratch temp for relocating @sym_insn_pc;
+     * NULL in other TBs.
+     */
+    TCGv_i64 sym_pc_delta;
+    TCGv_i64 sym_pc;
+    /* SymQEMU: vector scratch slots in use by the instrumentation. */
+    int sym_vec_scratch_used;
+    /*
+     * SymQEMU: fuse runs of pure symbolic helper calls into expression
+     * programs (see tcg/sym-program.c).
+     */
+    bool sym_fuse;
+
 #ifdef CONFIG_PLUGIN
     /*
      * We keep one plugin_tb struct per TCGContext. Note that on every TB
@@ -3471,7 +3471,7 @@ static void load_elf_image(const char *image_name, const ImageSource *src,
         info->end_data = info->end_code;
     }
 
-    if (qemu_log_enabled()) {
+    if (qemu_log_enabled() || want_elf_symbols) {
         load_symbols(ehdr, src, load_bias);
     }
 
@@ -3598,6 +3598,31 @@ static const char *lookup_symbolxx(struct syminfo *s, uint64_t orig_addr)
     return "";
 }
 
+bool want_elf_symbols;
+
+abi_ulong lookup_elf_symbol(const char *name)
+{
+    struct syminfo *s;
+
+    for (s = syminfos; s; s = s->next) {
+#if ELF_CLASS == ELFCLASS32
+        struct elf_sym *syms = s->disas_symtab.elf32;
+#else
+        struct elf_sym *syms = s->disas_symtab.elf64;
+#endif
+
+        if (s->lookup_symbol != lookup_symbolxx) {
+            continue;
+        }
+        for (unsigned int i = 0; i < s->disas_num_syms; i++) {
+            if (strcmp(s->disas_strtab + syms[i].st_name, name) == 0) {
+                return syms[i].st_value;
+            }
+        }
+    }
+    return 0;
+}
+
 /* FIXME: This should use elf_ops.h.inc  */
 static int symcmp(const void *s0, const void *s1)
 {
@@ -98,6 +98,12 @@ abi_long memcpy_to_target(abi_ulong dest, const void *src,
 
 extern unsigned long guest_stack_size;
 
+/* Load the symbol tables of guest binaries even when not logging. */
+extern bool want_elf_symbols;
+
+/* Address of the guest function @name, or 0 if it is not known. */
+abi_ulong lookup_elf_symbol(const char *name);
+
 #if defined(TARGET_S390X) || defined(TARGET_AARCH64) || defined(TARGET_ARM)
 uint32_t get_elf_hwcap(void);
 const char *elf_hwcap_str(uint32_t bit);
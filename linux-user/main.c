@@ -57,6 +57,7 @@
 #include "user-mmap.h"
 #include "tcg/perf.h"
 #include "exec/page-vary.h"
+#include "tcg/sym-fork-server.h"
 
 #ifdef CONFIG_SEMIHOSTING
 #include "semihosting/semihost.h"
@@ -74,6 +75,12 @@ char *exec_path;
 char real_exec_path[PATH_MAX];
 
 static bool opt_one_insn_per_tb;
+static bool opt_sym_fast_path;
+static bool opt_sym_dual_tb;
+static bool opt_sym_fuse;
+static uint32_t opt_sym_branch_budget;
+static const char *opt_sym_fork_server;
+static const char *opt_sym_persistent;
 static const char *argv0;
 static const char *gdbstub;
 static envlist_t *envlist;
@@ -158,6 +165,7 @@ void fork_end(pid_t pid)
 
     qemu_plugin_user_postfork(child);
     mmap_fork_end(child);
+    sym_fork_server_fork_end(child);
     if (child) {
         CPUState *cpu, *next_cpu;
         /* Child processes created by fork() only have a single thread.
@@ -420,6 +428,45 @@ static void handle_arg_one_insn_per_tb(const char *arg)
     opt_one_insn_per_tb = true;
 }
 
+static void handle_arg_sym_fast_path(const char *arg)
+{
+    opt_sym_fast_path = true;
+}
+
+static void handle_arg_sym_dual_tb(const char *arg)
+{
+    opt_sym_dual_tb = true;
+}
+
+static void handle_arg_sym_fuse(const char *arg)
+{
+    opt_sym_fuse = true;
+}
+
+static void handle_arg_sym_branch_budget(const char *arg)
+{
+    if (qemu_strtoui(arg, NULL, 0, &opt_sym_branch_budget)) {
+        usage(EXIT_FAILURE);
+    }
+}
+
+static void handle_arg_sym_fork_server(const char *arg)
+{
+    opt_sym_fork_server = arg;
+    /* Find "main" in the symbol tables once the binary is loaded. */
+    want_elf_symbols = strcmp(arg, "main") == 0;
+}
+
+static void handle_arg_sym_persistent(const char *arg)
+{
+    opt_sym_persistent = arg;
+}
+
+static void handle_arg_sym_batch(const char *arg)
+{
+    sym_batch_source = arg;
+}
+
 static void handle_arg_strace(const char *arg)
 {
     enable_strace = true;
@@ -509,6 +556,26 @@ static const struct qemu_argument arg_table[] = {
     {"one-insn-per-tb",
                    "QEMU_ONE_INSN_PER_TB",  false, handle_arg_one_insn_per_tb,
      "",           "run with one guest instruction per emulated TB"},
+    {"sym-fast-path",
+                   "SYMQEMU_FAST_PATH", false, handle_arg_sym_fast_path,
+     "",           "skip symbolic helpers inline when inputs are concrete"},
+    {"sym-dual-tb",
+                   "SYMQEMU_DUAL_TB",   false, handle_arg_sym_dual_tb,
+     "",           "run uninstrumented TBs while no symbolic state is live"},
+    {"sym-fuse",
+                   "SYMQEMU_FUSE",      false, handle_arg_sym_fuse,
+     "",           "fuse symbolic helper calls into expression programs"},
+    {"sym-branch-budget",
+                   "SYMQEMU_BRANCH_BUDGET", true, handle_arg_sym_branch_budget,
+     "queries",    "queries per branch site before backing off"},
+    {"sym-fork-server",
+                   "SYMQEMU_FORK_SERVER", true, handle_arg_sym_fork_server,
+     "where",      "start an AFL fork server at 'main', 'entry' or an address"},
+    {"sym-persistent",
+                   "SYMQEMU_PERSISTENT", true, handle_arg_sym_persistent,
+     "end",        "end each fork server run at address 'end'"},
+    {"sym-batch",  "SYMQEMU_BATCH",    true,  handle_arg_sym_batch,
+     "source",     "run the inputs of a directory or a list at the fork server"},
     {"strace",     "QEMU_STRACE",      false, handle_arg_strace,
      "",           "log system calls"},
     {"seed",       "QEMU_RAND_SEED",   true,  handle_arg_seed,
@@ -803,6 +870,14 @@ int main(int argc, char **argv, char **envp)
         accel_init_interfaces(ac);
         object_property_set_bool(OBJECT(accel), "one-insn-per-tb",
                                  opt_one_insn_per_tb, &error_abort);
+        object_property_set_bool(OBJECT(accel), "sym-fast-path",
+                                 opt_sym_fast_path, &error_abort);
+        object_property_set_bool(OBJECT(accel), "sym-dual-tb",
+                                 opt_sym_dual_tb, &error_abort);
+        object_property_set_bool(OBJECT(accel), "sym-fuse",
+                                 opt_sym_fuse, &error_abort);
+        object_property_set_uint(OBJECT(accel), "sym-branch-budget",
+                                 opt_sym_branch_budget, &error_abort);
         ac->init_machine(NULL);
     }
 
@@ -1006,6 +1081,47 @@ int main(int argc, char **argv, char **envp)
         }
     }
 
+    if (opt_sym_fork_server) {
+        uint64_t pc = 0;
+
+#ifdef CONFIG_SYMCC_RT_QSYM
+        /*
+         * The Qsym backend reads the input when _sym_initialize runs, long
+         * before the fork point, and can't be told to read it again: every
+         * child would solve against the input that the server started with.
+         */
+        fprintf(stderr, "-sym-fork-server is not supported with the Qsym "
+                "backend, which reads the input at startup\n");
+        exit(EXIT_FAILURE);
+#endif
+        if (strcmp(opt_sym_fork_server, "main") == 0) {
+            pc = lookup_elf_symbol("main");
+        } else if (strcmp(opt_sym_fork_server, "entry") != 0 &&
+                   qemu_strtou64(opt_sym_fork_server, NULL, 0, &pc)) {
+            usage(EXIT_FAILURE);
+        }
+        /* Without a symbol for main, start at the entry point. */
+        sym_fork_server_pc = pc ? pc : info->entry;
+    }
+
+    if (sym_batch_source && !opt_sym_fork_server) {
+        fprintf(stderr, "-sym-batch requires -sym-fork-server\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (opt_sym_persistent) {
+        uint64_t pc;
+
+        if (!opt_sym_fork_server) {
+            fprintf(stderr, "-sym-persistent requires -sym-fork-server\n");
+            exit(EXIT_FAILURE);
+        }
+        if (qemu_strtou64(opt_sym_persistent, NULL, 0, &pc)) {
+            usage(EXIT_FAILURE);
+        }
+        sym_persistent_end_pc = pc;
+    }
+
     target_set_brk(info->brk);
     syscall_init();
     signal_init();
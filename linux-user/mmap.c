@@ -26,6 +26,11 @@
 #include "user-mmap.h"
 #include "target_mman.h"
 #include "qemu/interval-tree.h"
+#include "qemu/bitmap.h"
+#include "tcg/sym-page-map.h"
+
+#define SymExpr void*
+#include "RuntimeCommon.h"
 
 #ifdef TARGET_ARM
 #include "target/arm/cpu-features.h"
@@ -947,6 +952,171 @@ static abi_long target_mmap__locked(abi_ulong start, abi_ulong len,
     }
 }
 
+/*
+ * SymQEMU: memory-mapped symbolic input
+ *
+ * Mappings of the input file are symbolized lazily, one page-map slot at a
+ * time. Their slots hold SYM_PAGE_MAP_INPUT until the symbolic helpers first
+ * access guest memory there and call sym_input_map_touch, which creates the
+ * input expressions of the slot at the right file offsets. System calls that
+ * write guest memory call sym_input_map_write first (see lock_user), so that
+ * what they write is not taken for input later. All of this is protected by
+ * the mmap lock.
+ */
+typedef struct SymInputMapping {
+    abi_ulong start;
+    abi_ulong len;              /* up to the end of the file */
+    off_t offset;
+    uint64_t first_slot;
+    uint64_t nb_slots;
+    unsigned long *pending;     /* slots that aren't symbolic yet */
+} SymInputMapping;
+
+static GPtrArray *sym_input_mappings;
+
+static void sym_input_map_free(guint i)
+{
+    SymInputMapping *m = g_ptr_array_index(sym_input_mappings, i);
+
+    g_ptr_array_remove_index_fast(sym_input_mappings, i);
+    g_free(m->pending);
+    g_free(m);
+}
+
+/* Forget the slots of input mappings that intersect [start, start+len). */
+static void sym_input_map_remove(abi_ulong start, abi_ulong len)
+{
+    uint64_t first = start >> SYM_PAGE_BITS;
+    uint64_t last = ((uint64_t)start + len - 1) >> SYM_PAGE_BITS;
+
+    for (guint i = sym_input_mappings ? sym_input_mappings->len : 0;
+         i-- > 0;) {
+        SymInputMapping *m = g_ptr_array_index(sym_input_mappings, i);
+        uint64_t from = MAX(first, m->first_slot);
+        uint64_t to = MIN(last, m->first_slot + m->nb_slots - 1);
+
+        if (from > to) {
+            continue;
+        }
+        bitmap_clear(m->pending, from - m->first_slot, to - from + 1);
+        if (bitmap_empty(m->pending, m->nb_slots)) {
+            sym_input_map_free(i);
+        }
+    }
+}
+
+static void sym_input_map_add(abi_ulong start, abi_ulong len, int prot,
+                              int fd, off_t offset)
+{
+    SymInputMapping *m;
+    struct stat st;
+
+    if (!(prot & PROT_READ) || !sym_is_input_fd(fd) || fstat(fd, &st) < 0 ||
+        !S_ISREG(st.st_mode) || offset >= st.st_size) {
+        return;
+    }
+
+    m = g_new0(SymInputMapping, 1);
+    m->start = start;
+    m->len = MIN(len, st.st_size - offset);
+    m->offset = offset;
+    m->first_slot = start >> SYM_PAGE_BITS;
+    m->nb_slots = ((start + m->len - 1) >> SYM_PAGE_BITS) - m->first_slot + 1;
+    m->pending = bitmap_new(m->nb_slots);
+    bitmap_fill(m->pending, m->nb_slots);
+    if (sym_input_mappings == NULL) {
+        sym_input_mappings = g_ptr_array_new();
+    }
+    g_ptr_array_add(sym_input_mappings, m);
+
+    /* Mark the slot in front as well, see sym_page_map_mark. */
+    sym_page_map_mark(m->start, m->len);
+    for (uint64_t i = 0; i < m->nb_slots && i < SYM_PAGE_MAP_SIZE; i++) {
+        sym_page_map[(m->first_slot + i) & (SYM_PAGE_MAP_SIZE - 1)] =
+            SYM_PAGE_MAP_INPUT;
+    }
+}
+
+/* Symbolize the input mapped at @slot, and clear its page-map slot if done. */
+static void sym_input_map_symbolize(uint64_t slot)
+{
+    uint64_t index = slot & (SYM_PAGE_MAP_SIZE - 1);
+    bool pending = false;
+
+    for (guint i = sym_input_mappings ? sym_input_mappings->len : 0;
+         i-- > 0;) {
+        SymInputMapping *m = g_ptr_array_index(sym_input_mappings, i);
+        uint64_t s;
+
+        if (slot >= m->first_slot && slot - m->first_slot < m->nb_slots &&
+            test_bit(slot - m->first_slot, m->pending)) {
+            abi_ulong begin = MAX(slot << SYM_PAGE_BITS, m->start);
+            abi_ulong end = MIN((slot + 1) << SYM_PAGE_BITS,
+                                (uint64_t)m->start + m->len);
+
+            if (page_check_range(begin, end - begin, PAGE_READ)) {
+                _sym_make_symbolic(g2h_untagged(begin), end - begin,
+                                   m->offset + (begin - m->start));
+                clear_bit(slot - m->first_slot, m->pending);
+            }
+            if (bitmap_empty(m->pending, m->nb_slots)) {
+                sym_input_map_free(i);
+                continue;
+            }
+        }
+
+        /* Slots of the mapping that share the page-map slot */
+        for (s = m->first_slot + ((index - m->first_slot) &
+                                  (SYM_PAGE_MAP_SIZE - 1));
+             s < m->first_slot + m->nb_slots && !pending;
+             s += SYM_PAGE_MAP_SIZE) {
+            pending = test_bit(s - m->first_slot, m->pending);
+        }
+    }
+
+    if (!pending) {
+        sym_page_map[index] = 1;
+    }
+}
+
+void sym_input_map_touch(uint64_t addr, uint64_t length)
+{
+    uint64_t first = addr >> SYM_PAGE_BITS;
+    uint64_t last = (addr + length - 1) >> SYM_PAGE_BITS;
+
+    mmap_lock();
+    for (uint64_t slot = first; slot <= last; slot++) {
+        if (sym_page_map[slot & (SYM_PAGE_MAP_SIZE - 1)] ==
+            SYM_PAGE_MAP_INPUT) {
+            sym_input_map_symbolize(slot);
+        }
+    }
+    mmap_unlock();
+}
+
+void sym_input_map_write(abi_ulong addr, abi_ulong len)
+{
+    uint64_t first = addr >> SYM_PAGE_BITS;
+    uint64_t last = ((uint64_t)addr + len - 1) >> SYM_PAGE_BITS;
+
+    if (len == 0) {
+        return;
+    }
+    for (uint64_t slot = first; slot <= last; slot++) {
+        abi_ulong begin = MAX(slot << SYM_PAGE_BITS, addr);
+        abi_ulong end = MIN((slot + 1) << SYM_PAGE_BITS, (uint64_t)addr + len);
+
+        if (sym_page_map[slot & (SYM_PAGE_MAP_SIZE - 1)] !=
+            SYM_PAGE_MAP_INPUT) {
+            continue;
+        }
+        mmap_lock();
+        sym_input_map_symbolize(slot);
+        mmap_unlock();
+        _sym_write_memory(g2h_untagged(begin), end - begin, NULL, true);
+    }
+}
+
 /* NOTE: all the constants are the HOST ones */
 abi_long target_mmap(abi_ulong start, abi_ulong len, int target_prot,
                      int flags, int fd, off_t offset)
@@ -993,6 +1163,12 @@ abi_long target_mmap(abi_ulong start, abi_ulong len, int target_prot,
 
     ret = target_mmap__locked(start, len, target_prot, flags,
                               page_flags, fd, offset);
+    if (ret != -1) {
+        sym_input_map_remove(ret, len);
+        if (!(flags & MAP_ANONYMOUS)) {
+            sym_input_map_add(ret, len, target_prot, fd, offset);
+        }
+    }
 
     mmap_unlock();
 
@@ -1092,6 +1268,7 @@ int target_munmap(abi_ulong start, abi_ulong len)
     if (likely(ret == 0)) {
         page_set_flags(start, start + len - 1, 0);
         shm_region_rm_complete(start, start + len - 1);
+        sym_input_map_remove(start, len);
     }
     mmap_unlock();
 
@@ -1183,6 +1360,7 @@ abi_long target_mremap(abi_ulong old_addr, abi_ulong old_size,
         prot = page_get_flags(old_addr);
         page_set_flags(old_addr, old_addr + old_size - 1, 0);
         shm_region_rm_complete(old_addr, old_addr + old_size - 1);
+        sym_input_map_remove(old_addr, old_size);
         page_set_flags(new_addr, new_addr + new_size - 1,
                        prot | PAGE_VALID | PAGE_RESET);
         shm_region_rm_complete(new_addr, new_addr + new_size - 1);
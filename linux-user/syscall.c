@@ -144,6 +144,10 @@
 #include "qapi/error.h"
 #include "fd-trans.h"
 #include "cpu_loop-common.h"
+#include "tcg/sym-page-map.h"
+
+#define SymExpr void*
+#include "RuntimeCommon.h"
 
 #ifndef CLONE_IO
 #define CLONE_IO                0x80000000      /* Clone io context */
@@ -430,6 +434,159 @@ int open_symbolized(const char *ptah, int oflag, mode_t mode);
 ssize_t read_symbolized(int fildes, void *buf, size_t nbyte);
 uint64_t lseek64_symbolized(int fd, uint64_t offset, int whence);
 
+/*
+ * Symbolic input through pread64, readv, preadv, recv and recvfrom
+ *
+ * read() goes through the runtime's read_symbolized, which counts the input
+ * offset itself. The other calls that read data find out where the input
+ * offset is with sym_input_begin, make the host call, and then let
+ * sym_input_end pass the data to the runtime as input bytes at that offset,
+ * one bulk write of shadow memory per buffer; for other files, it clears the
+ * shadow memory of the buffers instead, as read_symbolized does. Positional
+ * reads leave the file position and the runtime's offset alone; the others
+ * resynchronize the runtime's offset with the file position, so that later
+ * read() calls continue at the right input offset. The offset of an input
+ * that can't seek is only known to the runtime: readv and recv read it
+ * through read_symbolized instead (see sym_input_read_stream and
+ * sym_input_recv).
+ *
+ * Which descriptor is the input is up to the runtime, too: read_symbolized
+ * and lseek64_symbolized only treat the one that open_symbolized returned
+ * for the input file as input (or standard input, without SYMCC_INPUT_FILE),
+ * not its duplicates, and none at all with SYMCC_NO_SYMBOLIC_INPUT. Rather
+ * than guessing, sym_input_open asks the runtime about every regular file
+ * that the guest opens (see sym_input_probe) and remembers the answer.
+ */
+#define SYM_INPUT_CURRENT   ((off_t)-1)     /* read at the file position */
+#define SYM_INPUT_NONE      ((off_t)-2)     /* not the input */
+#define SYM_INPUT_STREAM    ((off_t)-3)     /* the input, at an unknown offset */
+
+static int sym_input_fd = -1;
+static bool sym_input_seekable;     /* the runtime confirmed a regular file */
+static bool sym_input_stdin_checked;
+
+/*
+ * Whether the runtime takes @fd, a regular file, for the input: read one byte
+ * through read_symbolized and see if it comes back symbolic, then seek back
+ * with lseek64_symbolized, which restores the runtime's input offset too.
+ */
+static bool sym_input_probe(int fd)
+{
+    struct stat st;
+    uint8_t byte;
+    off_t pos;
+    bool input;
+
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+        (pos = lseek(fd, 0, SEEK_CUR)) < 0) {
+        return false;
+    }
+    input = read_symbolized(fd, &byte, 1) == 1 &&
+            _sym_read_memory(&byte, 1, true) != NULL;
+    _sym_write_memory(&byte, 1, NULL, true);
+    lseek64_symbolized(fd, pos, SEEK_SET);
+    return input;
+}
+
+static int sym_input_open(const char *path, int flags, mode_t mode)
+{
+    int fd = open_symbolized(path, flags, mode);
+
+    if (fd < 0 || (flags & O_ACCMODE) == O_WRONLY) {
+        return fd;
+    }
+    if (sym_input_probe(fd)) {
+        sym_input_fd = fd;
+        sym_input_seekable = true;
+    } else if (fd == sym_input_fd) {
+        sym_input_fd = -1;
+    }
+    return fd;
+}
+
+bool sym_is_input_fd(int fd)
+{
+    /* Without SYMCC_INPUT_FILE, the runtime's input is standard input. */
+    if (fd == STDIN_FILENO && !sym_input_stdin_checked) {
+        struct stat st;
+
+        sym_input_stdin_checked = true;
+        if (g_getenv("SYMCC_INPUT_FILE") == NULL && sym_input_fd < 0) {
+            /* Only a regular file can be asked; read_symbolized decides. */
+            sym_input_seekable = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+            if (!sym_input_seekable || sym_input_probe(fd)) {
+                sym_input_fd = fd;
+            }
+        }
+    }
+    return fd >= 0 && fd == sym_input_fd;
+}
+
+static off_t sym_input_begin(int fd, off_t offset)
+{
+    if (!sym_is_input_fd(fd)) {
+        return SYM_INPUT_NONE;
+    }
+    if (!sym_input_seekable) {
+        return SYM_INPUT_STREAM;
+    }
+    if (offset == SYM_INPUT_CURRENT) {
+        offset = lseek(fd, 0, SEEK_CUR);
+        return offset < 0 ? SYM_INPUT_STREAM : offset;
+    }
+    return offset;
+}
+
+static void sym_input_end(int fd, off_t offset, bool advance,
+                          const struct iovec *vec, int count, size_t len)
+{
+    for (int i = 0; i < count && len > 0; i++) {
+        size_t n = MIN(vec[i].iov_len, len);
+
+        if (n == 0 || vec[i].iov_base == NULL) {
+            continue;
+        }
+        if (offset >= 0) {
+            _sym_make_symbolic(vec[i].iov_base, n, offset);
+            sym_page_map_mark(h2g(vec[i].iov_base), n);
+            offset += n;
+        } else {
+            _sym_write_memory(vec[i].iov_base, n, NULL, true);
+        }
+        len -= n;
+    }
+
+    if (advance && offset >= 0) {
+        lseek64_symbolized(fd, 0, SEEK_CUR);
+    }
+}
+
+static ssize_t sym_input_read_stream(int fd, const struct iovec *vec,
+                                     int count)
+{
+    ssize_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        ssize_t n;
+
+        if (vec[i].iov_len == 0) {
+            continue;
+        }
+        n = read_symbolized(fd, vec[i].iov_base, vec[i].iov_len);
+        if (n < 0) {
+            return total > 0 ? total : n;
+        }
+        if (n > 0) {
+            sym_page_map_mark(h2g(vec[i].iov_base), n);
+        }
+        total += n;
+        if ((size_t)n < vec[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
 static const bitmask_transtbl fcntl_flags_tbl[] = {
   { TARGET_O_ACCMODE,   TARGET_O_WRONLY,    O_ACCMODE,   O_WRONLY,    },
   { TARGET_O_ACCMODE,   TARGET_O_RDWR,      O_ACCMODE,   O_RDWR,      },
@@ -3572,6 +3729,34 @@ fail:
     return ret;
 }
 
+/*
+ * recv() and recvfrom() on an input that can't seek: peek at the data with
+ * the guest's flags, so that MSG_WAITALL, MSG_DONTWAIT and the source address
+ * behave as asked, then consume exactly those bytes through read_symbolized,
+ * which makes them symbolic and moves the runtime's input offset past them.
+ */
+static ssize_t sym_input_recv(int fd, void *buf, size_t len, int flags,
+                              struct sockaddr *addr, socklen_t *addrlen)
+{
+    ssize_t ret = safe_recvfrom(fd, buf, len, flags | MSG_PEEK,
+                                addr, addrlen);
+    ssize_t done = 0;
+
+    while (done < MIN(ret, (ssize_t)len)) {
+        ssize_t n = read_symbolized(fd, (uint8_t *)buf + done,
+                                    MIN(ret, (ssize_t)len) - done);
+
+        if (n <= 0) {
+            return done > 0 ? done : n;
+        }
+        done += n;
+    }
+    if (done > 0) {
+        sym_page_map_mark(h2g(buf), done);
+    }
+    return ret;
+}
+
 /* do_recvfrom() Must return target values and target errnos. */
 static abi_long do_recvfrom(int fd, abi_ulong msg, size_t len, int flags,
                             abi_ulong target_addr,
@@ -3580,6 +3765,7 @@ static abi_long do_recvfrom(int fd, abi_ulong msg, size_t len, int flags,
     socklen_t addrlen, ret_addrlen;
     void *addr;
     void *host_msg;
+    bool sym_stream;
     abi_long ret;
 
     if (!msg) {
@@ -3590,6 +3776,14 @@ static abi_long do_recvfrom(int fd, abi_ulong msg, size_t len, int flags,
             return -TARGET_EFAULT;
         }
     }
+    /*
+     * Input that can't seek is received through read_symbolized. Peeking
+     * doesn't consume it, and out-of-band data, the error queue and
+     * MSG_TRUNC (which discards data) are received concretely.
+     */
+    sym_stream = host_msg != NULL &&
+        !(flags & (MSG_PEEK | MSG_OOB | MSG_TRUNC | MSG_ERRQUEUE)) &&
+        sym_input_begin(fd, SYM_INPUT_CURRENT) == SYM_INPUT_STREAM;
     if (target_addr) {
         if (get_user_u32(addrlen, target_addrlen)) {
             ret = -TARGET_EFAULT;
@@ -3601,14 +3795,30 @@ static abi_long do_recvfrom(int fd, abi_ulong msg, size_t len, int flags,
         }
         addr = alloca(addrlen);
         ret_addrlen = addrlen;
-        ret = get_errno(safe_recvfrom(fd, host_msg, len, flags,
-                                      addr, &ret_addrlen));
+        if (sym_stream) {
+            ret = get_errno(sym_input_recv(fd, host_msg, len, flags,
+                                           addr, &ret_addrlen));
+        } else {
+            ret = get_errno(safe_recvfrom(fd, host_msg, len, flags,
+                                          addr, &ret_addrlen));
+        }
     } else {
         addr = NULL; /* To keep compiler quiet.  */
         addrlen = 0; /* To keep compiler quiet.  */
-        ret = get_errno(safe_recvfrom(fd, host_msg, len, flags, NULL, 0));
+        if (sym_stream) {
+            ret = get_errno(sym_input_recv(fd, host_msg, len, flags,
+                                           NULL, NULL));
+        } else {
+            ret = get_errno(safe_recvfrom(fd, host_msg, len, flags, NULL, 0));
+        }
     }
     if (!is_error(ret)) {
+        if (host_msg != NULL && !sym_stream) {
+            struct iovec vec = { .iov_base = host_msg, .iov_len = len };
+
+            /* Anything else is received as concrete data. */
+            sym_input_end(fd, SYM_INPUT_NONE, false, &vec, 1, MIN(ret, len));
+        }
         if (fd_trans_host_to_target_data(fd)) {
             abi_long trans;
             trans = fd_trans_host_to_target_data(fd)(host_msg, MIN(ret, len));
@@ -8427,7 +8637,7 @@ int do_guest_openat(CPUArchState *cpu_env, int dirfd, const char *fname,
 
     if (safe) {
         if (dirfd == AT_FDCWD)
-            return open_symbolized(path(pathname), flags, mode);
+            return sym_input_open(path(pathname), flags, mode);
         else
             return safe_openat(dirfd, path(pathname), flags, mode);
     } else {
@@ -9160,6 +9370,10 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
             if (!(p = lock_user(VERIFY_WRITE, arg2, arg3, 0)))
                 return -TARGET_EFAULT;
             ret = get_errno(read_symbolized(arg1, p, arg3));
+            if (ret > 0) {
+                /* The data may be symbolic (if arg1 is the input). */
+                sym_page_map_mark(arg2, ret);
+            }
             if (ret >= 0 &&
                 fd_trans_host_to_target_data(arg1)) {
                 ret = fd_trans_host_to_target_data(arg1)(p, ret);
@@ -11204,7 +11418,16 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
         {
             struct iovec *vec = lock_iovec(VERIFY_WRITE, arg2, arg3, 0);
             if (vec != NULL) {
-                ret = get_errno(safe_readv(arg1, vec, arg3));
+                off_t offset = sym_input_begin(arg1, SYM_INPUT_CURRENT);
+
+                if (offset == SYM_INPUT_STREAM) {
+                    ret = get_errno(sym_input_read_stream(arg1, vec, arg3));
+                } else {
+                    ret = get_errno(safe_readv(arg1, vec, arg3));
+                    if (!is_error(ret)) {
+                        sym_input_end(arg1, offset, true, vec, arg3, ret);
+                    }
+                }
                 unlock_iovec(vec, arg2, arg3, 1);
             } else {
                 ret = -host_to_target_errno(errno);
@@ -11231,6 +11454,13 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
 
                 target_to_host_low_high(arg4, arg5, &low, &high);
                 ret = get_errno(safe_preadv(arg1, vec, arg3, low, high));
+                if (!is_error(ret)) {
+                    off_t pos = low | ((uint64_t)high << HOST_LONG_BITS / 2)
+                                      << HOST_LONG_BITS / 2;
+
+                    sym_input_end(arg1, sym_input_begin(arg1, pos), false,
+                                  vec, arg3, ret);
+                }
                 unlock_iovec(vec, arg2, arg3, 1);
             } else {
                 ret = -host_to_target_errno(errno);
@@ -11537,6 +11767,13 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
             }
         }
         ret = get_errno(pread64(arg1, p, arg3, target_offset64(arg4, arg5)));
+        if (!is_error(ret) && p != NULL) {
+            struct iovec vec = { .iov_base = p, .iov_len = arg3 };
+
+            sym_input_end(arg1, sym_input_begin(arg1,
+                                                target_offset64(arg4, arg5)),
+                          false, &vec, 1, ret);
+        }
         unlock_user(p, arg2, ret);
         return ret;
     case TARGET_NR_pwrite64:
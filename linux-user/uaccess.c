@@ -4,6 +4,7 @@
 
 #include "qemu.h"
 #include "user-internals.h"
+#include "user-mmap.h"
 
 void *lock_user(int type, abi_ulong guest_addr, ssize_t len, bool copy)
 {
@@ -13,6 +14,9 @@ void *lock_user(int type, abi_ulong guest_addr, ssize_t len, bool copy)
     if (!access_ok_untagged(type, guest_addr, len)) {
         return NULL;
     }
+    if (type == VERIFY_WRITE) {
+        sym_input_map_write(guest_addr, len);
+    }
     host_addr = g2h_untagged(guest_addr);
 #ifdef CONFIG_DEBUG_REMAP
     if (copy) {
@@ -97,6 +97,8 @@ void probe_guest_base(const char *image_name,
 
 /* syscall.c */
 int host_to_target_waitstatus(int status);
+/* Whether the runtime symbolizes what is read from @fd. */
+bool sym_is_input_fd(int fd);
 
 #ifdef TARGET_I386
 /* vm86.c */
@@ -62,4 +62,11 @@ abi_ulong target_shmat(CPUArchState *cpu_env, int shmid,
                        abi_ulong shmaddr, int shmflg);
 abi_long target_shmdt(abi_ulong shmaddr);
 
+/*
+ * A system call is about to write to [addr, addr + len): symbolize the
+ * mapped input that is still pending around it, and make the range itself
+ * concrete.
+ */
+void sym_input_map_write(abi_ulong addr, abi_ulong len);
+
 #endif /* LINUX_USER_USER_MMAP_H */
@@ -1440,6 +1440,7 @@ static bool trans_B(DisasContext *s, arg_i *a)
 static bool trans_BL(DisasContext *s, arg_i *a)
 {
     gen_pc_plus_diff(s, cpu_reg(s, 30), curr_insn_len(s));
+    tcg_gen_sym_notify_call(cpu_reg(s, 30));
     reset_btype(s);
     gen_goto_tb(s, 0, a->imm);
     return true;
@@ -1544,6 +1545,7 @@ static bool trans_BLR(DisasContext *s, arg_r *a)
         dst = tmp;
     }
     gen_pc_plus_diff(s, lr, curr_insn_len(s));
+    tcg_gen_sym_notify_call(lr);
     gen_a64_set_pc(s, dst);
     set_btype_for_blr(s);
     s->base.is_jmp = DISAS_JUMP;
@@ -1552,6 +1554,7 @@ static bool trans_BLR(DisasContext *s, arg_r *a)
 
 static bool trans_RET(DisasContext *s, arg_r *a)
 {
+    tcg_gen_sym_notify_return(cpu_reg(s, a->rn));
     gen_a64_set_pc(s, cpu_reg(s, a->rn));
     s->base.is_jmp = DISAS_JUMP;
     return true;
@@ -1610,6 +1613,7 @@ static bool trans_BLRAZ(DisasContext *s, arg_braz *a)
         dst = tmp;
     }
     gen_pc_plus_diff(s, lr, curr_insn_len(s));
+    tcg_gen_sym_notify_call(lr);
     gen_a64_set_pc(s, dst);
     set_btype_for_blr(s);
     s->base.is_jmp = DISAS_JUMP;
@@ -1621,6 +1625,7 @@ static bool trans_RETA(DisasContext *s, arg_reta *a)
     TCGv_i64 dst;
 
     dst = auth_branch_target(s, cpu_reg(s, 30), cpu_X[31], !a->m);
+    tcg_gen_sym_notify_return(dst);
     gen_a64_set_pc(s, dst);
     s->base.is_jmp = DISAS_JUMP;
     return true;
@@ -1655,6 +1660,7 @@ static bool trans_BLRA(DisasContext *s, arg_bra *a)
         dst = tmp;
     }
     gen_pc_plus_diff(s, lr, curr_insn_len(s));
+    tcg_gen_sym_notify_call(lr);
     gen_a64_set_pc(s, dst);
     set_btype_for_blr(s);
     s->base.is_jmp = DISAS_JUMP;
@@ -555,6 +555,16 @@ static void gen_set_fpr_d(DisasContext *ctx, int reg_num, TCGv_i64 t)
     }
 }
 
+/*
+ * As in the return-address stack hints of the ISA, a jump that links x1 or
+ * x5 is a call for the symbolic backend, and a jalr through one of them that
+ * doesn't link it is a return.
+ */
+static bool is_link_reg(int reg)
+{
+    return reg == 1 || reg == 5;
+}
+
 static void gen_jal(DisasContext *ctx, int rd, target_ulong imm)
 {
     TCGv succ_pc = dest_gpr(ctx, rd);
@@ -571,6 +581,9 @@ static void gen_jal(DisasContext *ctx, int rd, target_ulong imm)
 
     gen_pc_plus_diff(succ_pc, ctx, ctx->cur_insn_len);
     gen_set_gpr(ctx, rd, succ_pc);
+    if (is_link_reg(rd)) {
+        tcg_gen_sym_notify_call(succ_pc);
+    }
 
     gen_goto_tb(ctx, 0, imm); /* must use this for safety */
     ctx->base.is_jmp = DISAS_NORETURN;
@@ -1503,6 +1503,48 @@ static bool fold_bswap(OptContext *ctx, TCGOp *op)
     return fold_masks(ctx, op);
 }
 
+/*
+ * SymQEMU: a symbolic helper flagged TCG_CALL_SYM_NULL_PRESERVING returns a
+ * NULL expression, without any other effect, when all of its expression
+ * arguments are NULL. If we can prove this at translation time, replace the
+ * call with a move of 0 into the result expression (or drop it if there is no
+ * result); the result may in turn make later helper calls of the TB foldable.
+ */
+static bool fold_sym_call(OptContext *ctx, TCGOp *op)
+{
+    const TCGHelperInfo *info = tcg_call_info(op);
+    int nb_oargs = TCGOP_CALLO(op);
+    int nb_iargs = TCGOP_CALLI(op);
+    int i;
+
+    if (!(info->flags & TCG_CALL_SYM_NULL_PRESERVING)) {
+        return false;
+    }
+
+    for (i = 0; i < nb_iargs; i++) {
+        int arg_idx = info->in[i].arg_idx;
+
+        /*
+         * The pointer parameters of these helpers are the expressions. Go by
+         * the signature rather than by the temp: after copy propagation, an
+         * expression argument may have been replaced by any constant.
+         */
+        if (extract64(info->typemask, (arg_idx + 1) * 3, 3) ==
+                dh_typecode_ptr &&
+            !arg_is_const_val(op->args[nb_oargs + i], 0)) {
+            return false;
+        }
+    }
+
+    if (nb_oargs == 0) {
+        /* E.g., branch helpers that would only push a path constraint. */
+        tcg_op_remove(ctx->tcg, op);
+        return true;
+    }
+    ctx->type = TCG_TYPE_PTR;
+    return tcg_opt_gen_movi(ctx, op, op->args[0], 0);
+}
+
 static bool fold_call(OptContext *ctx, TCGOp *op)
 {
     TCGContext *s = ctx->tcg;
@@ -1513,6 +1555,10 @@ static bool fold_call(OptContext *ctx, TCGOp *op)
     init_arguments(ctx, op, nb_oargs + nb_iargs);
     copy_propagate(ctx, op, nb_oargs, nb_iargs);
 
+    if (fold_sym_call(ctx, op)) {
+        return true;
+    }
+
     /* If the function reads or writes globals, reset temp data. */
     flags = tcg_call_flags(op);
     if (!(flags & (TCG_CALL_NO_READ_GLOBALS | TCG_CALL_NO_WRITE_GLOBALS))) {
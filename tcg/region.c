@@ -386,6 +386,26 @@ bool tcg_region_alloc(TCGContext *s)
     return err;
 }
 
+/*
+ * Allocate @size bytes of data from the end of the region in use, so that
+ * the data lives exactly as long as the code generated into the region.
+ * Returns NULL if the region cannot spare the space; the caller must then
+ * do without.
+ */
+void *tcg_region_data_alloc(TCGContext *s, size_t size)
+{
+    void *end = s->code_gen_buffer + s->code_gen_buffer_size;
+    void *data = QEMU_ALIGN_PTR_DOWN(end - size, 16);
+
+    if (size > s->code_gen_buffer_size ||
+        data - TCG_HIGHWATER < s->code_gen_ptr) {
+        return NULL;
+    }
+    s->code_gen_buffer_size = data - s->code_gen_buffer;
+    s->code_gen_highwater = data - TCG_HIGHWATER;
+    return data;
+}
+
 /*
  * Perform a context's first region allocation.
  * This function does _not_ increment region.agg_size_full.
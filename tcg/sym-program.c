@@ -0,0 +1,314 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Fusion of symbolic helper calls into expression programs
+ *
+ * A run is a sequence of calls to pure symbolic helpers (flagged
+ * TCG_CALL_SYM_NULL_PRESERVING and without side effects) that is not
+ * interrupted by anything that could observe the expressions they compute:
+ * labels, branches, other calls, memory accesses and any op reading one of
+ * the pending result expressions. Copies of pending results are folded into
+ * the run. Each run of at least two calls becomes a single call to
+ * helper_sym_run_program at its end (see include/tcg/sym-program.h).
+ */
+
+#include "qemu/osdep.h"
+#include "tcg/tcg.h"
+#include "tcg/tcg-op-common.h"
+#include "tcg/sym-program.h"
+#include "tcg-internal.h"
+
+typedef struct SymRunCall {
+    TCGOp *op;
+    SymProgramEntry entry;
+    /* For SYM_PROGRAM_ARG_SLOT arguments: the temp to store. */
+    TCGTemp *stores[SYM_PROGRAM_MAX_ARGS];
+} SymRunCall;
+
+typedef struct SymRun {
+    SymRunCall calls[SYM_PROGRAM_MAX_ENTRIES];
+    int nb_calls;
+    int nb_slots;
+    /* Copies of pending results, removed when the run is fused. */
+    GPtrArray *copies;
+    /* For each temp index, 1 + the entry whose result it holds, or 0. */
+    uint8_t *pending;
+    int nb_pending_temps;
+} SymRun;
+
+/* The offset from env of the part of @slot that a value of @type occupies. */
+static int sym_slot_offset(int slot, TCGType type)
+{
+    int ofs = offsetof(CPUNegativeOffsetState, sym_slots[slot]) -
+              sizeof(CPUNegativeOffsetState);
+
+    return HOST_BIG_ENDIAN && type == TCG_TYPE_I32 ? ofs + 4 : ofs;
+}
+
+static int sym_run_pending(SymRun *run, TCGTemp *ts)
+{
+    size_t idx = temp_idx(ts);
+
+    return idx < run->nb_pending_temps ? run->pending[idx] - 1 : -1;
+}
+
+static void sym_run_set_pending(SymRun *run, TCGTemp *ts, int entry)
+{
+    size_t idx = temp_idx(ts);
+
+    if (idx < run->nb_pending_temps) {
+        run->pending[idx] = entry + 1;
+    }
+}
+
+static TCGOp *sym_insert_op(TCGContext *s, TCGOp *before,
+                            TCGOpcode opc, unsigned nargs)
+{
+    if (before) {
+        return tcg_op_insert_before(s, before, opc, nargs);
+    }
+    return tcg_emit_op(opc, nargs);
+}
+
+static bool sym_call_fusable(TCGOp *op)
+{
+    const TCGHelperInfo *info = tcg_call_info(op);
+    unsigned flags = info->flags;
+    int i, nb_params = 0;
+
+    if (!(flags & TCG_CALL_SYM_NULL_PRESERVING) ||
+        (flags & TCG_CALL_NO_RWG_SE) != TCG_CALL_NO_RWG_SE ||
+        TCGOP_CALLO(op) != 1 || sym_program_call(info) == NULL) {
+        return false;
+    }
+
+    /* Only plain register-sized arguments, one input per parameter. */
+    for (i = 1; i <= SYM_PROGRAM_MAX_ARGS + 1; i++) {
+        if (extract64(info->typemask, i * 3, 3) == dh_typecode_void) {
+            break;
+        }
+        nb_params++;
+    }
+    return nb_params <= SYM_PROGRAM_MAX_ARGS && nb_params == TCGOP_CALLI(op);
+}
+
+/* Describe a fusable call as a program entry; false if the run is full. */
+static bool sym_run_add_call(SymRun *run, TCGOp *op)
+{
+    const TCGHelperInfo *info = tcg_call_info(op);
+    SymRunCall *call = &run->calls[run->nb_calls];
+    int nb_iargs = TCGOP_CALLI(op);
+    int i, nb_slots = 1;
+
+    /* Count the slots first, so that a full run is left untouched. */
+    for (i = 0; i < nb_iargs; i++) {
+        TCGTemp *ts = arg_temp(op->args[1 + i]);
+
+        if (ts->kind != TEMP_CONST && sym_run_pending(run, ts) < 0) {
+            nb_slots++;
+        }
+    }
+    if (run->nb_calls == SYM_PROGRAM_MAX_ENTRIES ||
+        run->nb_slots + nb_slots > SYM_PROGRAM_NB_SLOTS) {
+        return false;
+    }
+
+    memset(call, 0, sizeof(*call));
+    call->op = op;
+    call->entry.call = sym_program_call(info);
+    call->entry.nb_args = nb_iargs;
+    call->entry.result_slot = run->nb_slots++;
+
+    for (i = 0; i < nb_iargs; i++) {
+        TCGTemp *ts = arg_temp(op->args[1 + i]);
+        SymProgramArg *arg = &call->entry.args[i];
+        int entry = sym_run_pending(run, ts);
+
+        /* The pointer arguments of pure symbolic helpers are expressions. */
+        arg->is_expr = extract64(info->typemask, (i + 1) * 3, 3) ==
+                       dh_typecode_ptr;
+
+        if (ts->kind == TEMP_CONST) {
+            arg->kind = SYM_PROGRAM_ARG_CONST;
+            arg->val = ts->val;
+        } else if (entry >= 0) {
+            arg->kind = SYM_PROGRAM_ARG_RESULT;
+            arg->val = entry;
+        } else {
+            arg->kind = SYM_PROGRAM_ARG_SLOT;
+            arg->val = run->nb_slots++;
+            call->stores[i] = ts;
+        }
+    }
+
+    sym_run_set_pending(run, arg_temp(op->args[0]), run->nb_calls);
+    run->nb_calls++;
+    return true;
+}
+
+static void sym_run_reset(SymRun *run)
+{
+    run->nb_calls = 0;
+    run->nb_slots = 0;
+    g_ptr_array_set_size(run->copies, 0);
+    memset(run->pending, 0, run->nb_pending_temps);
+}
+
+/* Replace the run by a program call in front of @before (NULL: at the end). */
+static void sym_run_flush(TCGContext *s, SymRun *run, TCGOp *before)
+{
+    TCGTemp *env = tcgv_ptr_temp(tcg_env);
+    SymProgram *prog;
+    size_t size;
+    int i, j;
+
+    if (run->nb_calls < 2) {
+        sym_run_reset(run);
+        return;
+    }
+
+    size = sizeof(SymProgram) + run->nb_calls * sizeof(SymProgramEntry);
+    prog = tcg_region_data_alloc(s, size);
+    if (prog == NULL) {
+        /* No room left in the region: keep the individual calls. */
+        sym_run_reset(run);
+        return;
+    }
+    memset(prog, 0, size);
+    prog->nb_entries = run->nb_calls;
+
+    for (i = 0; i < run->nb_calls; i++) {
+        SymRunCall *call = &run->calls[i];
+
+        prog->entries[i] = call->entry;
+        for (j = 0; j < call->entry.nb_args; j++) {
+            TCGTemp *ts = call->stores[j];
+            TCGOp *st;
+
+            if (ts == NULL) {
+                continue;
+            }
+            if (call->entry.args[j].is_expr) {
+                prog->inputs[prog->nb_inputs++] = call->entry.args[j].val;
+            }
+            st = tcg_op_insert_before(s, call->op,
+                                      ts->type == TCG_TYPE_I32
+                                      ? INDEX_op_st_i32 : INDEX_op_st_i64, 3);
+            st->args[0] = temp_arg(ts);
+            st->args[1] = temp_arg(env);
+            st->args[2] = sym_slot_offset(call->entry.args[j].val, ts->type);
+        }
+        tcg_op_remove(s, call->op);
+    }
+
+    for (i = 0; i < run->copies->len; i++) {
+        tcg_op_remove(s, g_ptr_array_index(run->copies, i));
+    }
+
+    s->emit_before_op = before;
+    gen_helper_sym_run_program(tcg_env,
+                               tcg_constant_ptr(tcg_splitwx_to_rx(prog)));
+    s->emit_before_op = NULL;
+
+    /* Load the results that are still held by their temps. */
+    for (i = 0; i < run->nb_pending_temps; i++) {
+        TCGTemp *ts = &s->temps[i];
+        TCGOp *ld;
+
+        if (run->pending[i] == 0) {
+            continue;
+        }
+        ld = sym_insert_op(s, before, ts->type == TCG_TYPE_I32
+                           ? INDEX_op_ld_i32 : INDEX_op_ld_i64, 3);
+        ld->args[0] = temp_arg(ts);
+        ld->args[1] = temp_arg(env);
+        ld->args[2] = sym_slot_offset(
+            prog->entries[run->pending[i] - 1].result_slot, ts->type);
+    }
+
+    sym_run_reset(run);
+}
+
+static bool sym_op_ends_run(TCGOp *op)
+{
+    const TCGOpDef *def = &tcg_op_defs[op->opc];
+
+    return op->opc == INDEX_op_set_label || op->opc == INDEX_op_call ||
+           (def->flags & (TCG_OPF_BB_END | TCG_OPF_BB_EXIT |
+                          TCG_OPF_SIDE_EFFECTS | TCG_OPF_CALL_CLOBBER));
+}
+
+void tcg_sym_fuse(TCGContext *s)
+{
+    SymRun run = { 0 };
+    TCGOp *op, *op_next;
+
+    run.copies = g_ptr_array_new();
+    run.nb_pending_temps = s->nb_temps;
+    run.pending = tcg_malloc(run.nb_pending_temps);
+    memset(run.pending, 0, run.nb_pending_temps);
+
+    QTAILQ_FOREACH_SAFE(op, &s->ops, link, op_next) {
+        const TCGOpDef *def = &tcg_op_defs[op->opc];
+        int nb_oargs, nb_iargs, i;
+        bool reads_pending = false;
+
+        if (op->opc == INDEX_op_call && sym_call_fusable(op)) {
+            if (!sym_run_add_call(&run, op)) {
+                sym_run_flush(s, &run, op);
+                sym_run_add_call(&run, op);
+            }
+            continue;
+        }
+
+        if (op->opc == INDEX_op_call) {
+            nb_oargs = TCGOP_CALLO(op);
+            nb_iargs = TCGOP_CALLI(op);
+        } else {
+            nb_oargs = def->nb_oargs;
+            nb_iargs = def->nb_iargs;
+        }
+
+        for (i = nb_oargs; i < nb_oargs + nb_iargs; i++) {
+            if (sym_run_pending(&run, arg_temp(op->args[i])) >= 0) {
+                reads_pending = true;
+            }
+        }
+
+        /* A copy of a pending result just becomes another result temp. */
+        if (reads_pending &&
+            (op->opc == INDEX_op_mov_i32 || op->opc == INDEX_op_mov_i64)) {
+            sym_run_set_pending(&run, arg_temp(op->args[0]),
+                                sym_run_pending(&run, arg_temp(op->args[1])));
+            g_ptr_array_add(run.copies, op);
+            continue;
+        }
+
+        if (reads_pending || sym_op_ends_run(op)) {
+            sym_run_flush(s, &run, op);
+            continue;
+        }
+
+        /* Temps overwritten here no longer hold a pending result. */
+        for (i = 0; i < nb_oargs; i++) {
+            sym_run_set_pending(&run, arg_temp(op->args[i]), -1);
+        }
+    }
+    sym_run_flush(s, &run, NULL);
+
+    g_ptr_array_free(run.copies, true);
+}
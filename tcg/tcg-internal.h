@@ -37,6 +37,7 @@ extern unsigned int tcg_max_ctxs;
 void tcg_region_init(size_t tb_size, int splitwx, unsigned max_cpus);
 bool tcg_region_alloc(TCGContext *s);
 void tcg_region_initial_alloc(TCGContext *s);
+void *tcg_region_data_alloc(TCGContext *s, size_t size);
 void tcg_region_prologue_set(TCGContext *s);
 
 static inline void *tcg_call_func(TCGOp *op)
@@ -103,4 +104,21 @@ void vec_gen_2(TCGOpcode, TCGType, unsigned, TCGArg, TCGArg);
 void vec_gen_3(TCGOpcode, TCGType, unsigned, TCGArg, TCGArg, TCGArg);
 void vec_gen_4(TCGOpcode, TCGType, unsigned, TCGArg, TCGArg, TCGArg, TCGArg);
 
+void tcg_sym_fuse(TCGContext *s);
+
+/* The guest PC of the current instruction, for symbolic helpers. */
+static inline TCGv_i64 tcg_sym_pc(void)
+{
+    TCGv_i64 pc = temp_tcgv_i64(tcg_constant_internal(TCG_TYPE_I64,
+                                                      tcg_ctx->sym_insn_pc));
+
+    /* A PC-relative TB runs at whatever address it was entered with. */
+    if (tcg_ctx->sym_pc_delta) {
+        tcg_gen_op3(INDEX_op_add_i64, tcgv_i64_arg(tcg_ctx->sym_pc),
+                    tcgv_i64_arg(tcg_ctx->sym_pc_delta), tcgv_i64_arg(pc));
+        return tcg_ctx->sym_pc;
+    }
+    return pc;
+}
+
 #endif /* TCG_INTERNAL_H */
@@ -182,6 +182,48 @@ plugin_gen_mem_callbacks(TCGv_i64 copy_addr, TCGTemp *orig_addr, MemOpIdx oi,
 #endif
 }
 
+/*
+ * The concrete clone of a TB (CF_SYM_CONCRETE) does not track loaded values;
+ * instead, we check that the bytes just loaded are concrete and otherwise
+ * restart the instruction in the instrumented variant of the TB.
+ */
+static void gen_sym_check_concrete_load(TCGv_i64 addr, TCGv_i64 load_size,
+                                        TCGv_i64 mmu_idx)
+{
+    if (tcg_ctx->sym_concrete_tb) {
+        gen_helper_sym_check_concrete_load(tcg_env, addr, load_size, mmu_idx);
+    }
+}
+
+/*
+ * Skip the symbolic part of a guest load if the address is concrete and the
+ * page map says that it points into memory without symbolic data (only with
+ * sym-fast-path in user mode; see tcg_gen_sym_memory_fast_path_begin).
+ */
+static TCGSymFastPath *gen_sym_load_fast_path_begin(TCGv_ptr val_expr,
+                                                    TCGv_i64 addr)
+{
+    return tcg_gen_sym_memory_fast_path_begin(val_expr, addr, 1,
+                                              (TCGv_ptr[]){ tcgv_i64_expr(addr) });
+}
+
+/*
+ * Likewise for the symbolic part of a guest store, which can be skipped if
+ * the value is concrete as well: there is no symbolic data to overwrite.
+ */
+static TCGSymFastPath *gen_sym_store_fast_path_begin(TCGv_ptr val_expr,
+                                                     TCGTemp *addr)
+{
+    TCGv_i64 addr64 = temp_tcgv_i64(addr);
+
+    /* The inline page map test works on 64-bit addresses. */
+    if (tcg_ctx->addr_type != TCG_TYPE_I64) {
+        return NULL;
+    }
+    return tcg_gen_sym_memory_fast_path_begin(
+        NULL, addr64, 2, (TCGv_ptr[]){ val_expr, tcgv_i64_expr(addr64) });
+}
+
 static void tcg_gen_qemu_ld_i32_int(TCGv_i32 val, TCGTemp *addr,
                                     TCGArg idx, MemOp memop)
 {
@@ -190,6 +232,7 @@ static void tcg_gen_qemu_ld_i32_int(TCGv_i32 val, TCGTemp *addr,
     TCGv_i64 copy_addr;
     TCGOpcode opc;
     TCGv_i64 load_size, mmu_idx;
+    TCGSymFastPath *sym_skip;
 
     tcg_gen_req_mo(TCG_MO_LD_LD | TCG_MO_ST_LD);
     orig_memop = memop = tcg_canonicalize_memop(memop, 0, 0);
@@ -217,9 +260,12 @@ static void tcg_gen_qemu_ld_i32_int(TCGv_i32 val, TCGTemp *addr,
      * operation ensures that the target address is in the TLB. */
     load_size = tcg_constant_i64(1 << (memop & MO_SIZE));
     mmu_idx = tcg_constant_i64(idx);
+    sym_skip = gen_sym_load_fast_path_begin(tcgv_i32_expr(val), copy_addr);
     gen_helper_sym_load_guest_i32(tcgv_i32_expr(val), tcg_env,
                                   copy_addr, tcgv_i64_expr(copy_addr),
-                                  load_size, mmu_idx);
+                                  load_size, mmu_idx, tcg_sym_pc());
+    tcg_gen_sym_fast_path_end(sym_skip);
+    gen_sym_check_concrete_load(copy_addr, load_size, mmu_idx);
 
     if ((orig_memop ^ memop) & MO_BSWAP) {
         switch (orig_memop & MO_SIZE) {
@@ -252,6 +298,7 @@ static void tcg_gen_qemu_st_i32_int(TCGv_i32 val, TCGTemp *addr,
     MemOpIdx orig_oi, oi;
     TCGOpcode opc;
     TCGv_i64 store_size = NULL, mmu_idx = NULL;
+    TCGSymFastPath *sym_skip;
 
     tcg_gen_req_mo(TCG_MO_LD_ST | TCG_MO_ST_ST);
     memop = tcg_canonicalize_memop(memop, 0, 1);
@@ -294,10 +341,12 @@ static void tcg_gen_qemu_st_i32_int(TCGv_i32 val, TCGTemp *addr,
      * operation ensures that the target address is in the TLB. */
     store_size = tcg_constant_i64(1 << (memop & MO_SIZE));
     mmu_idx = tcg_constant_i64(idx);
+    sym_skip = gen_sym_store_fast_path_begin(tcgv_i32_expr(val), addr);
     gen_helper_sym_store_guest_i32(tcg_env,
                                    val, tcgv_i32_expr(val),
                                    temp_tcgv_i64(addr), tcgv_i64_expr(temp_tcgv_i64(addr)),
-                                   store_size, mmu_idx);
+                                   store_size, mmu_idx, tcg_sym_pc());
+    tcg_gen_sym_fast_path_end(sym_skip);
 
     if (swap) {
         tcg_temp_free_i32(swap);
@@ -320,6 +369,7 @@ static void tcg_gen_qemu_ld_i64_int(TCGv_i64 val, TCGTemp *addr,
     TCGv_i64 copy_addr;
     TCGOpcode opc;
     TCGv_i64 load_size, mmu_idx;
+    TCGSymFastPath *sym_skip;
 
     if (TCG_TARGET_REG_BITS == 32 && (memop & MO_SIZE) < MO_64) {
         tcg_gen_qemu_ld_i32_int(TCGV_LOW(val), addr, idx, memop);
@@ -357,9 +407,12 @@ static void tcg_gen_qemu_ld_i64_int(TCGv_i64 val, TCGTemp *addr,
     * operation ensures that the target address is in the TLB. */
     mmu_idx = tcg_constant_i64(idx);
     load_size = tcg_constant_i64(1 << (memop & MO_SIZE));
+    sym_skip = gen_sym_load_fast_path_begin(tcgv_i64_expr(val), copy_addr);
     gen_helper_sym_load_guest_i64(tcgv_i64_expr(val), tcg_env,
                                   copy_addr, tcgv_i64_expr(copy_addr),
-                                  load_size, mmu_idx);
+                                  load_size, mmu_idx, tcg_sym_pc());
+    tcg_gen_sym_fast_path_end(sym_skip);
+    gen_sym_check_concrete_load(copy_addr, load_size, mmu_idx);
 
     if ((orig_memop ^ memop) & MO_BSWAP) {
         int flags = (orig_memop & MO_SIGN
@@ -393,6 +446,7 @@ static void tcg_gen_qemu_st_i64_int(TCGv_i64 val, TCGTemp *addr,
                                     TCGArg idx, MemOp memop)
 {
     TCGv_i64 swap = NULL, store_size = NULL, mmu_idx = NULL;
+    TCGSymFastPath *sym_skip;
     MemOpIdx orig_oi, oi;
     TCGOpcode opc;
 
@@ -437,10 +491,12 @@ static void tcg_gen_qemu_st_i64_int(TCGv_i64 val, TCGTemp *addr,
     * operation ensures that the target address is in the TLB. */
     mmu_idx = tcg_constant_i64(idx);
     store_size = tcg_constant_i64(1 << (memop & MO_SIZE));
+    sym_skip = gen_sym_store_fast_path_begin(tcgv_i64_expr(val), addr);
     gen_helper_sym_store_guest_i64(tcg_env,
                                    val, tcgv_i64_expr(val),
                                    temp_tcgv_i64(addr), tcgv_i64_expr(temp_tcgv_i64(addr)),
-                                   store_size, mmu_idx);
+                                   store_size, mmu_idx, tcg_sym_pc());
+    tcg_gen_sym_fast_path_end(sym_skip);
 
     if (swap) {
         tcg_temp_free_i64(swap);
@@ -598,6 +654,7 @@ static void tcg_gen_qemu_ld_i128_int(TCGv_i128 val, TCGTemp *addr,
         TCGv_i64 x, y;
         bool need_bswap;
         TCGv_i64 load_size, mmu_idx;
+        TCGSymFastPath *sym_skip;
 
         canonicalize_memop_i128_as_i64(mop, memop);
         need_bswap = (mop[0] ^ memop) & MO_BSWAP;
@@ -627,9 +684,16 @@ static void tcg_gen_qemu_ld_i128_int(TCGv_i128 val, TCGTemp *addr,
         * operation ensures that the target address is in the TLB. */
         mmu_idx = tcg_constant_i64(idx);
         load_size = tcg_constant_i64(1 << MO_64);
+        sym_skip = NULL;
+        if (tcg_ctx->addr_type == TCG_TYPE_I64) {
+            sym_skip = gen_sym_load_fast_path_begin(tcgv_i64_expr(x),
+                                                    temp_tcgv_i64(addr));
+        }
         gen_helper_sym_load_guest_i64(tcgv_i64_expr(x),tcg_env,
                                       temp_tcgv_i64(addr), tcgv_i64_expr(temp_tcgv_i64(addr)),
-                                      load_size, mmu_idx);
+                                      load_size, mmu_idx, tcg_sym_pc());
+        tcg_gen_sym_fast_path_end(sym_skip);
+        gen_sym_check_concrete_load(temp_tcgv_i64(addr), load_size, mmu_idx);
 
         if (need_bswap) {
             tcg_gen_bswap64_i64(x, x);
@@ -649,9 +713,16 @@ static void tcg_gen_qemu_ld_i128_int(TCGv_i128 val, TCGTemp *addr,
 
         /* Perform the symbolic memory access. Doing so _after_ the concrete
         * operation ensures that the target address is in the TLB. */
+        sym_skip = NULL;
+        if (tcg_ctx->addr_type == TCG_TYPE_I64) {
+            sym_skip = gen_sym_load_fast_path_begin(tcgv_i64_expr(y),
+                                                    temp_tcgv_i64(addr_p8));
+        }
         gen_helper_sym_load_guest_i64(tcgv_i64_expr(y), tcg_env,
                                       temp_tcgv_i64(addr_p8), tcgv_i64_expr(temp_tcgv_i64(addr_p8)),
-                                      load_size, mmu_idx);
+                                      load_size, mmu_idx, tcg_sym_pc());
+        tcg_gen_sym_fast_path_end(sym_skip);
+        gen_sym_check_concrete_load(temp_tcgv_i64(addr_p8), load_size, mmu_idx);
 
         tcg_temp_free_internal(addr_p8);
 
@@ -733,6 +804,7 @@ static void tcg_gen_qemu_st_i128_int(TCGv_i128 val, TCGTemp *addr,
         TCGTemp *addr_p8;
         TCGv_i64 x, y, b = NULL;
         TCGv_i64 store_size, mmu_idx;
+        TCGSymFastPath *sym_skip;
 
         canonicalize_memop_i128_as_i64(mop, memop);
 
@@ -762,10 +834,12 @@ static void tcg_gen_qemu_st_i128_int(TCGv_i128 val, TCGTemp *addr,
         * operation ensures that the target address is in the TLB. */
         mmu_idx = tcg_constant_i64(idx);
         store_size = tcg_constant_i64(1 << MO_64);
+        sym_skip = gen_sym_store_fast_path_begin(tcgv_i64_expr(x), addr);
         gen_helper_sym_store_guest_i64(tcg_env,
                                        x, tcgv_i64_expr(x),
                                        temp_tcgv_i64(addr), tcgv_i64_expr(temp_tcgv_i64(addr)),
-                                       store_size, mmu_idx);
+                                       store_size, mmu_idx, tcg_sym_pc());
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         if (tcg_ctx->addr_type == TCG_TYPE_I32) {
             TCGv_i32 t = tcg_temp_ebb_new_i32();
@@ -783,10 +857,12 @@ static void tcg_gen_qemu_st_i128_int(TCGv_i128 val, TCGTemp *addr,
 
             /* Perform the symbolic memory access. Doing so _after_ the concrete
             * operation ensures that the target address is in the TLB. */
+            sym_skip = gen_sym_store_fast_path_begin(tcgv_i64_expr(b), addr_p8);
             gen_helper_sym_store_guest_i64(tcg_env,
                                            b, tcgv_i64_expr(b),
                                            temp_tcgv_i64(addr_p8), tcgv_i64_expr(temp_tcgv_i64(addr_p8)),
-                                           store_size, mmu_idx);
+                                           store_size, mmu_idx, tcg_sym_pc());
+            tcg_gen_sym_fast_path_end(sym_skip);
 
             tcg_temp_free_i64(b);
         } else {
@@ -794,10 +870,12 @@ static void tcg_gen_qemu_st_i128_int(TCGv_i128 val, TCGTemp *addr,
 
             /* Perform the symbolic memory access. Doing so _after_ the concrete
             * operation ensures that the target address is in the TLB. */
+            sym_skip = gen_sym_store_fast_path_begin(tcgv_i64_expr(y), addr_p8);
             gen_helper_sym_store_guest_i64(tcg_env,
                                            y, tcgv_i64_expr(y),
                                            temp_tcgv_i64(addr_p8), tcgv_i64_expr(temp_tcgv_i64(addr_p8)),
-                                           store_size, mmu_idx);
+                                           store_size, mmu_idx, tcg_sym_pc());
+            tcg_gen_sym_fast_path_end(sym_skip);
         }
         tcg_temp_free_internal(addr_p8);
     /* } else {
@@ -23,6 +23,7 @@
 #include "tcg/tcg-op-common.h"
 #include "tcg/tcg-mo.h"
 #include "tcg-internal.h"
+#include "hw/core/cpu.h"
 
 static int vec_size(TCGv_vec vector){
     switch(tcgv_vec_temp(vector)->base_type) {
@@ -37,16 +38,33 @@ static int vec_size(TCGv_vec vector){
     }
 }
 
-/* Adds TCG ops for storing a vector TCG variable in a heap buffer.
+/* Adds TCG ops for storing a vector TCG variable in a per-vCPU scratch slot
+ * (CPUNegativeOffsetState.sym_vec_scratch). Slots are handed out like a stack,
+ * because expanding a vector op may emit further instrumented vector ops
+ * while the operands of the outer one are still needed. If the expansion
+ * nests too deeply, the vector is stored in a heap buffer instead.
  *
- * The caller must add TCG ops for freeing the buffer.
+ * The caller must add TCG ops for releasing the buffer with
+ * release_vector_memory, in reverse order of the stores.
  *
  * Returns
  *      A TCG variable that will contain the buffer address at run time.
  */
 static TCGv_ptr store_vector_in_memory(TCGv_vec vector){
     TCGv_ptr buffer_address = tcg_temp_new_ptr();
-    gen_helper_malloc(buffer_address, tcg_constant_i64(vec_size(vector) / 8));
+    int slot = tcg_ctx->sym_vec_scratch_used++;
+
+    if (slot < SYM_VEC_SCRATCH_SLOTS) {
+        intptr_t ofs = offsetof(CPUNegativeOffsetState, sym_vec_scratch[slot]) -
+                       sizeof(CPUNegativeOffsetState);
+
+        tcg_debug_assert(vec_size(vector) / 8 <= SYM_VEC_SCRATCH_SLOT_SIZE);
+        tcg_gen_op3(INDEX_op_add_i64, tcgv_ptr_arg(buffer_address),
+                    tcgv_ptr_arg(tcg_env), tcgv_i64_arg(tcg_constant_i64(ofs)));
+    } else {
+        gen_helper_malloc(buffer_address,
+                          tcg_constant_i64(vec_size(vector) / 8));
+    }
 
     /* store vector at buffer_address */
     vec_gen_3(
@@ -61,11 +79,22 @@ static TCGv_ptr store_vector_in_memory(TCGv_vec vector){
     return buffer_address;
 }
 
+/* Adds TCG ops for releasing the most recent buffer of store_vector_in_memory. */
+static void release_vector_memory(TCGv_ptr buffer_address)
+{
+    int slot = --tcg_ctx->sym_vec_scratch_used;
+
+    if (slot >= SYM_VEC_SCRATCH_SLOTS) {
+        gen_helper_free(buffer_address);
+    }
+    tcg_temp_free_ptr(buffer_address);
+}
+
 /* Adds instrumentation TCG ops for an instruction of the form vec = vec <op> vec.
  *
  * Args
  *      vece: element size in bits = 8 * 2^vece
- *      r: output operand
+ *      r: output operand (may be the same as a)
  *      a: first input operand
  *      b: second input operand
  *      sym_helper: function for calling the symbolic helper
@@ -75,11 +104,25 @@ static void vec_vec_op_instrumentation(
         TCGv_vec r, TCGv_vec a, TCGv_vec b,
         void (*sym_helper)(TCGv_ptr, TCGv_ptr, TCGv_ptr, TCGv_ptr, TCGv_ptr, TCGv_i64, TCGv_i64)
 ) {
-    TCGv_ptr buffer_address_a = store_vector_in_memory(a);
-    TCGv_ptr buffer_address_b = store_vector_in_memory(b);
-    int size_a = vec_size(a);
-    int size_b = vec_size(b);
-    int size_r = vec_size(r);
+    TCGv_ptr buffer_address_a, buffer_address_b;
+    TCGSymFastPath *sym_skip;
+    int size_a, size_b, size_r;
+
+    if (tcg_ctx->sym_concrete_tb) {
+        /* The helper is dropped in concrete TBs; don't spill the operands. */
+        tcg_gen_mov_i64_concrete(tcgv_vec_expr_num(r), tcg_constant_i64(0));
+        return;
+    }
+
+    /* Only spill the operands and call the helper if one is symbolic. */
+    sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_vec_expr(r), tcgv_vec_expr(a), tcgv_vec_expr(b));
+
+    buffer_address_a = store_vector_in_memory(a);
+    buffer_address_b = store_vector_in_memory(b);
+    size_a = vec_size(a);
+    size_b = vec_size(b);
+    size_r = vec_size(r);
 
     g_assert(size_a == size_b && size_b == size_r);
 
@@ -93,8 +136,9 @@ static void vec_vec_op_instrumentation(
             tcg_constant_i64(vece)
     );
 
-    gen_helper_free(buffer_address_a);
-    gen_helper_free(buffer_address_b);
+    release_vector_memory(buffer_address_b);
+    release_vector_memory(buffer_address_a);
+    tcg_gen_sym_fast_path_end(sym_skip);
 }
 
 /*
@@ -102,7 +146,7 @@ static void vec_vec_op_instrumentation(
  *
  * Args
  *      vece: element size in bits = 8 * 2^vece
- *      r: output operand
+ *      r: output operand (may be the same as a)
  *      a: first input operand
  *      b: second input operand
  *      sym_helper: function for calling the symbolic helper
@@ -112,9 +156,23 @@ static void vec_int32_op_instrumentation(
         TCGv_vec r, TCGv_vec a, TCGv_i32 b,
         void (*sym_helper)(TCGv_ptr, TCGv_ptr, TCGv_ptr, TCGv_i32, TCGv_ptr, TCGv_i64, TCGv_i64)
 ) {
-    TCGv_ptr buffer_address_a = store_vector_in_memory(a);
-    int size_a = vec_size(a);
-    int size_r = vec_size(r);
+    TCGv_ptr buffer_address_a;
+    TCGSymFastPath *sym_skip;
+    int size_a, size_r;
+
+    if (tcg_ctx->sym_concrete_tb) {
+        /* The helper is dropped in concrete TBs; don't spill the operands. */
+        tcg_gen_mov_i64_concrete(tcgv_vec_expr_num(r), tcg_constant_i64(0));
+        return;
+    }
+
+    /* Only spill the operand and call the helper if an input is symbolic. */
+    sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_vec_expr(r), tcgv_vec_expr(a), tcgv_i32_expr(b));
+
+    buffer_address_a = store_vector_in_memory(a);
+    size_a = vec_size(a);
+    size_r = vec_size(r);
 
     g_assert(size_a == size_r);
 
@@ -128,7 +186,8 @@ static void vec_int32_op_instrumentation(
             tcg_constant_i64(vece)
     );
 
-    gen_helper_free(buffer_address_a);
+    release_vector_memory(buffer_address_a);
+    tcg_gen_sym_fast_path_end(sym_skip);
 }
 
 /*
@@ -785,7 +844,7 @@ void tcg_gen_cmp_vec(TCGCond cond, unsigned vece,
 
     gen_helper_sym_cmp_vec(
             tcgv_vec_expr(r),
-            tcg_env,
+            tcg_sym_pc(),
             buffer_address_a,
             tcgv_vec_expr(a),
             buffer_address_b,
@@ -796,9 +855,9 @@ void tcg_gen_cmp_vec(TCGCond cond, unsigned vece,
             tcg_constant_i64(vece)
     );
 
-    gen_helper_free(buffer_address_a);
-    gen_helper_free(buffer_address_b);
-    gen_helper_free(buffer_address_r);
+    release_vector_memory(buffer_address_r);
+    release_vector_memory(buffer_address_b);
+    release_vector_memory(buffer_address_a);
 
     if (tt) {
         tcg_temp_free_internal(tt);
@@ -938,7 +997,7 @@ static void do_minmax(unsigned vece, TCGv_vec r, TCGv_vec a,
 
     gen_helper_sym_ternary_vec(
             tcgv_vec_expr(r),
-            tcg_env,
+            tcg_sym_pc(),
             buffer_address_a,
             tcgv_vec_expr(a),
             buffer_address_b,
@@ -949,9 +1008,9 @@ static void do_minmax(unsigned vece, TCGv_vec r, TCGv_vec a,
             tcg_constant_i64(vece)
     );
 
-    gen_helper_free(buffer_address_a);
-    gen_helper_free(buffer_address_b);
-    gen_helper_free(buffer_address_r);
+    release_vector_memory(buffer_address_r);
+    release_vector_memory(buffer_address_b);
+    release_vector_memory(buffer_address_a);
 }
 
 void tcg_gen_smin_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
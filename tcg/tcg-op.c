@@ -26,6 +26,8 @@
 #include "tcg/tcg.h"
 #include "tcg/tcg-temp-internal.h"
 #include "tcg/tcg-op-common.h"
+#include "tcg/sym-page-map.h"
+#include "hw/core/cpu.h"
 #include "exec/translation-block.h"
 #include "exec/plugin-gen.h"
 #include "tcg-internal.h"
@@ -383,6 +385,180 @@ static void add_last_as_label_use(TCGLabel *l)
     QSIMPLEQ_INSERT_TAIL(&l->branches, u, next);
 }
 
+/*
+ * SymQEMU inline concreteness fast path.
+ *
+ * The vast majority of executed symbolic helpers see only NULL input
+ * expressions and return NULL right away. When the fast path is enabled, we
+ * test the input expressions inline and branch around the helper call if they
+ * are all NULL, so that the concrete case costs a couple of host instructions
+ * instead of a call. The result expression is only cleared on the skip path:
+ * it may alias one of the inputs, which the helper still has to see, and a
+ * NULL stored ahead of the call would let the optimizer fold the call away.
+ * The ops emitted here are deliberately not instrumented.
+ */
+struct TCGSymFastPath {
+    TCGLabel *skip;
+    TCGv_ptr ret_expr;
+};
+
+static inline TCGv_i64 sym_expr_num(TCGv_ptr expr)
+{
+    return temp_tcgv_i64(tcgv_ptr_temp(expr));
+}
+
+/* Branch around the helper call if @any is zero. */
+static TCGSymFastPath *sym_fast_path_branch(TCGv_ptr ret_expr, TCGv_i64 any)
+{
+    TCGSymFastPath *fp = tcg_malloc(sizeof(TCGSymFastPath));
+
+    fp->skip = gen_new_label();
+    fp->ret_expr = ret_expr;
+    tcg_gen_op4ii_i64(INDEX_op_brcond_i64, any, tcg_constant_i64(0),
+                      TCG_COND_EQ, label_arg(fp->skip));
+    add_last_as_label_use(fp->skip);
+    tcg_temp_free_i64(any);
+
+    return fp;
+}
+
+/* Combine the input expressions into a new temp, nonzero if any is symbolic. */
+static TCGv_i64 sym_fast_path_combine(int nb_exprs, const TCGv_ptr *exprs)
+{
+    TCGv_i64 any = tcg_temp_ebb_new_i64();
+
+    tcg_debug_assert(nb_exprs > 0);
+
+    tcg_gen_op2_i64(INDEX_op_mov_i64, any, sym_expr_num(exprs[0]));
+    for (int i = 1; i < nb_exprs; i++) {
+        tcg_gen_op3_i64(INDEX_op_or_i64, any, any, sym_expr_num(exprs[i]));
+    }
+    return any;
+}
+
+TCGSymFastPath *tcg_gen_sym_fast_path_begin(TCGv_ptr ret_expr, int nb_exprs,
+                                            const TCGv_ptr *exprs)
+{
+    if (!tcg_ctx->sym_fast_path || tcg_ctx->sym_concrete_tb) {
+        return NULL;
+    }
+
+    return sym_fast_path_branch(ret_expr,
+                                sym_fast_path_combine(nb_exprs, exprs));
+}
+
+TCGSymFastPath *tcg_gen_sym_memory_fast_path_begin(TCGv_ptr ret_expr,
+                                                   TCGv_i64 addr,
+                                                   int nb_exprs,
+                                                   const TCGv_ptr *exprs)
+{
+#ifdef CONFIG_USER_ONLY
+    TCGv_i64 any, slot;
+
+    if (!tcg_ctx->sym_fast_path || tcg_ctx->sym_concrete_tb) {
+        return NULL;
+    }
+
+    /* any = exprs[0] | ... | sym_page_map[sym_page_map_index(addr)] */
+    any = sym_fast_path_combine(nb_exprs, exprs);
+    slot = tcg_temp_ebb_new_i64();
+    tcg_gen_op3_i64(INDEX_op_shr_i64, slot, addr,
+                    tcg_constant_i64(SYM_PAGE_BITS));
+    tcg_gen_op3_i64(INDEX_op_and_i64, slot, slot,
+                    tcg_constant_i64(SYM_PAGE_MAP_SIZE - 1));
+    tcg_gen_op3_i64(INDEX_op_add_i64, slot, slot,
+                    tcg_constant_i64((uintptr_t)sym_page_map));
+    tcg_gen_op3(INDEX_op_ld8u_i64, tcgv_i64_arg(slot), tcgv_i64_arg(slot), 0);
+    tcg_gen_op3_i64(INDEX_op_or_i64, any, any, slot);
+    tcg_temp_free_i64(slot);
+
+    return sym_fast_path_branch(ret_expr, any);
+#else
+    /* Guest virtual addresses may alias in system mode, so the page map
+     * can't tell that an access is concrete. */
+    return NULL;
+#endif
+}
+
+/*
+ * Close the region: the helper falls through to @done, while the skip path
+ * clears the result expression on its own.
+ */
+void tcg_gen_sym_fast_path_end(TCGSymFastPath *fp)
+{
+    TCGLabel *done;
+
+    if (!fp) {
+        return;
+    }
+
+    if (!fp->ret_expr) {
+        gen_set_label(fp->skip);
+        return;
+    }
+
+    done = gen_new_label();
+    tcg_gen_op1(INDEX_op_br, label_arg(done));
+    add_last_as_label_use(done);
+    gen_set_label(fp->skip);
+    tcg_gen_op2_i64(INDEX_op_mov_i64, sym_expr_num(fp->ret_expr),
+                    tcg_constant_i64(0));
+    gen_set_label(done);
+}
+
+void tcg_gen_sym_notify_block(uint64_t pc)
+{
+    int ofs = offsetof(CPUNegativeOffsetState, sym_block_pc) -
+              sizeof(CPUNegativeOffsetState);
+    TCGv_i64 block = tcg_constant_i64(pc);
+
+    /* Concrete clones don't report coverage to the backend. */
+    if (tcg_ctx->sym_concrete_tb) {
+        return;
+    }
+
+    /* The runtime passes the block to the backend before its next query. */
+    if (tcg_ctx->sym_pc_delta) {
+        block = tcg_temp_ebb_new_i64();
+        tcg_gen_op3_i64(INDEX_op_add_i64, block, tcg_ctx->sym_pc_delta,
+                        tcg_constant_i64(pc));
+    }
+    tcg_gen_op3(INDEX_op_st_i64, tcgv_i64_arg(block),
+                tcgv_ptr_arg(tcg_env), ofs);
+    if (tcg_ctx->sym_pc_delta) {
+        tcg_temp_free_i64(block);
+    }
+}
+
+void tcg_gen_sym_notify_call_i64(TCGv_i64 ret_addr)
+{
+    gen_helper_sym_notify_call(ret_addr);
+}
+
+void tcg_gen_sym_notify_call_i32(TCGv_i32 ret_addr)
+{
+    TCGv_i64 t = tcg_temp_ebb_new_i64();
+
+    /* Not tcg_gen_extu_i32_i64, which would build an expression for t. */
+    tcg_gen_op2(INDEX_op_extu_i32_i64, tcgv_i64_arg(t), tcgv_i32_arg(ret_addr));
+    gen_helper_sym_notify_call(t);
+    tcg_temp_free_i64(t);
+}
+
+void tcg_gen_sym_notify_return_i64(TCGv_i64 ret_addr)
+{
+    gen_helper_sym_notify_return(ret_addr);
+}
+
+void tcg_gen_sym_notify_return_i32(TCGv_i32 ret_addr)
+{
+    TCGv_i64 t = tcg_temp_ebb_new_i64();
+
+    tcg_gen_op2(INDEX_op_extu_i32_i64, tcgv_i64_arg(t), tcgv_i32_arg(ret_addr));
+    gen_helper_sym_notify_return(t);
+    tcg_temp_free_i64(t);
+}
+
 void tcg_gen_br(TCGLabel *l)
 {
     tcg_gen_op1(INDEX_op_br, label_arg(l));
@@ -494,7 +670,10 @@ void tcg_gen_subi_i32(TCGv_i32 ret, TCGv_i32 arg1, int32_t arg2)
 
 void tcg_gen_neg_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
+    TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_i32_expr(ret), tcgv_i32_expr(arg));
     gen_helper_sym_neg(tcgv_i32_expr(ret), tcgv_i32_expr(arg));
+    tcg_gen_sym_fast_path_end(sym_skip);
     tcg_gen_op2_i32(INDEX_op_neg_i32, ret, arg);
 }
 
@@ -563,7 +742,10 @@ void tcg_gen_xori_i32(TCGv_i32 ret, TCGv_i32 arg1, int32_t arg2)
         tcg_gen_mov_i32(ret, arg1);
     } else if (arg2 == -1 && TCG_TARGET_HAS_not_i32) {
         /* Don't recurse with tcg_gen_not_i32.  */
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg1));
         gen_helper_sym_not(tcgv_i32_expr(ret), tcgv_i32_expr(arg1));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_not_i32, ret, arg1);
     } else {
         tcg_gen_xor_i32(ret, arg1, tcg_constant_i32(arg2));
@@ -573,7 +755,10 @@ void tcg_gen_xori_i32(TCGv_i32 ret, TCGv_i32 arg1, int32_t arg2)
 void tcg_gen_not_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_not_i32) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_not(tcgv_i32_expr(ret), tcgv_i32_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_not_i32, ret, arg);
     } else {
         tcg_gen_xori_i32(ret, arg, -1);
@@ -633,10 +818,14 @@ void tcg_gen_brcond_i32(TCGCond cond, TCGv_i32 arg1, TCGv_i32 arg2, TCGLabel *l)
     if (cond == TCG_COND_ALWAYS) {
         tcg_gen_br(l);
     } else if (cond != TCG_COND_NEVER) {
-        /* Generate a setcond for effects in the symbolic backend */
-        TCGv_i32 cond_result_temp = tcg_temp_new_i32();
-        tcg_gen_setcond_i32(cond, cond_result_temp, arg1, arg2);
-        tcg_temp_free_i32(cond_result_temp);
+        /* The helper derives the direction from the concrete operands. */
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            NULL, tcgv_i32_expr(arg1), tcgv_i32_expr(arg2));
+        gen_helper_sym_brcond_i32(tcg_sym_pc(),
+                                  arg1, tcgv_i32_expr(arg1),
+                                  arg2, tcgv_i32_expr(arg2),
+                                  tcg_constant_i32(cond));
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         tcg_gen_op4ii_i32(INDEX_op_brcond_i32, arg1, arg2, cond, label_arg(l));
         add_last_as_label_use(l);
@@ -661,11 +850,14 @@ void tcg_gen_setcond_i32(TCGCond cond, TCGv_i32 ret,
         tcg_gen_movi_i32(ret, 0);
     } else {
         tcg_gen_op4i_i32(INDEX_op_setcond_i32, ret, arg1, arg2, cond);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg1), tcgv_i32_expr(arg2));
         gen_helper_sym_setcond_i32(
-            tcgv_i32_expr(ret), tcg_env,
+            tcgv_i32_expr(ret), tcg_sym_pc(),
             arg1, tcgv_i32_expr(arg1),
             arg2, tcgv_i32_expr(arg2),
             tcg_constant_i32(cond), ret);
+        tcg_gen_sym_fast_path_end(sym_skip);
     }
 }
 
@@ -1045,11 +1237,14 @@ void tcg_gen_deposit_i32(TCGv_i32 ret, TCGv_i32 arg1, TCGv_i32 arg2,
     }
     if (TCG_TARGET_HAS_deposit_i32 && TCG_TARGET_deposit_i32_valid(ofs, len)) {
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg1), tcgv_i32_expr(arg2));
         gen_helper_sym_deposit_i32(tcgv_i32_expr(ret),
                                    arg1, tcgv_i32_expr(arg1),
                                    arg2, tcgv_i32_expr(arg2),
                                    tcg_constant_i32(ofs),
                                    tcg_constant_i32(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op5ii_i32(INDEX_op_deposit_i32, ret, arg1, arg2, ofs, len);
 
         return;
@@ -1099,11 +1294,14 @@ void tcg_gen_deposit_z_i32(TCGv_i32 ret, TCGv_i32 arg,
                && TCG_TARGET_deposit_i32_valid(ofs, len)) {
         TCGv_i32 zero = tcg_constant_i32(0);
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(zero), tcgv_i32_expr(arg));
         gen_helper_sym_deposit_i32(tcgv_i32_expr(ret),
                                    zero, tcgv_i32_expr(zero),
                                    arg, tcgv_i32_expr(arg),
                                    tcg_constant_i32(ofs),
                                    tcg_constant_i32(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         tcg_gen_op5ii_i32(INDEX_op_deposit_i32, ret, zero, arg, ofs, len);
     } else {
@@ -1168,9 +1366,12 @@ void tcg_gen_extract_i32(TCGv_i32 ret, TCGv_i32 arg,
     if (TCG_TARGET_HAS_extract_i32
         && TCG_TARGET_extract_i32_valid(ofs, len)) {
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_extract_i32(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg),
             tcg_constant_i32(ofs), tcg_constant_i32(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         tcg_gen_op4ii_i32(INDEX_op_extract_i32, ret, arg, ofs, len);
         return;
@@ -1236,9 +1437,12 @@ void tcg_gen_sextract_i32(TCGv_i32 ret, TCGv_i32 arg,
     if (TCG_TARGET_HAS_sextract_i32
         && TCG_TARGET_extract_i32_valid(ofs, len)) {
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_sextract_i32(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg),
             tcg_constant_i32(ofs), tcg_constant_i32(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         tcg_gen_op4ii_i32(INDEX_op_sextract_i32, ret, arg, ofs, len);
         return;
@@ -1300,11 +1504,14 @@ void tcg_gen_extract2_i32(TCGv_i32 ret, TCGv_i32 al, TCGv_i32 ah,
 
         TCGv_i64 ofs_tmp;
         ofs_tmp = tcg_constant_i64(ofs);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(ah), tcgv_i32_expr(al));
         gen_helper_sym_extract2_i32(
             tcgv_i32_expr(ret),
             ah, tcgv_i32_expr(ah),
             al, tcgv_i32_expr(al),
             ofs_tmp);
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         tcg_gen_op4i_i32(INDEX_op_extract2_i32, ret, al, ah, ofs);
     } else {
@@ -1345,14 +1552,19 @@ void tcg_gen_movcond_i32(TCGCond cond, TCGv_i32 ret, TCGv_i32 c1,
         tcg_temp_free_i64(c1_tmp);
         tcg_temp_free_i64(c2_tmp);
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret),
+            tcgv_i32_expr(c1), tcgv_i32_expr(c2),
+            tcgv_i32_expr(v1), tcgv_i32_expr(v2));
         gen_helper_sym_movcond_i32(
-                tcgv_i32_expr(ret), tcg_env,
+                tcgv_i32_expr(ret), tcg_sym_pc(),
                 c1, tcgv_i32_expr(c1),
                 c2, tcgv_i32_expr(c2),
                 v1, tcgv_i32_expr(v1),
                 v2, tcgv_i32_expr(v2),
                 tcg_constant_i32(cond),
                 ret);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op6i_i32(INDEX_op_movcond_i32, ret, c1, c2, v1, v2, cond);
     }
 }
@@ -1492,8 +1704,11 @@ void tcg_gen_ext8s_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_ext8s_i32) {
         TCGv_i64 target_len = tcg_constant_i64(1);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_sext(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), target_len);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_ext8s_i32, ret, arg);
     } else {
         tcg_gen_shli_i32(ret, arg, 24);
@@ -1505,8 +1720,11 @@ void tcg_gen_ext16s_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_ext16s_i32) {
         TCGv_i64 target_len = tcg_constant_i64(2);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_sext(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), target_len);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_ext16s_i32, ret, arg);
     } else {
         tcg_gen_shli_i32(ret, arg, 16);
@@ -1518,8 +1736,11 @@ void tcg_gen_ext8u_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_ext8u_i32) {
         TCGv_i64 target_len = tcg_constant_i64(1);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_zext(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), target_len);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_ext8u_i32, ret, arg);
     } else {
         tcg_gen_andi_i32(ret, arg, 0xffu);
@@ -1530,8 +1751,11 @@ void tcg_gen_ext16u_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_ext16u_i32) {
         TCGv_i64 target_len = tcg_constant_i64(2);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_zext(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), target_len);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i32(INDEX_op_ext16u_i32, ret, arg);
     } else {
         tcg_gen_andi_i32(ret, arg, 0xffffu);
@@ -1553,8 +1777,11 @@ void tcg_gen_bswap16_i32(TCGv_i32 ret, TCGv_i32 arg, int flags)
 
     if (TCG_TARGET_HAS_bswap16_i32) {
         TCGv_i64 length = tcg_constant_i64(2);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_bswap(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), length);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op3i_i32(INDEX_op_bswap16_i32, ret, arg, flags);
     } else {
         TCGv_i32 t0 = tcg_temp_ebb_new_i32();
@@ -1593,8 +1820,11 @@ void tcg_gen_bswap32_i32(TCGv_i32 ret, TCGv_i32 arg)
 {
     if (TCG_TARGET_HAS_bswap32_i32) {
         TCGv_i64 length = tcg_constant_i64(4);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_bswap(
             tcgv_i32_expr(ret), tcgv_i32_expr(arg), length);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op3i_i32(INDEX_op_bswap32_i32, ret, arg, 0);
     } else {
         TCGv_i32 t0 = tcg_temp_ebb_new_i32();
@@ -1930,9 +2160,12 @@ void tcg_gen_xor_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 
 void tcg_gen_shl_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 {
+    TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
     gen_helper_sym_shift_left_i64(tcgv_i64_expr(ret),
                                   arg1, tcgv_i64_expr(arg1),
                                   arg2, tcgv_i64_expr(arg2));
+    tcg_gen_sym_fast_path_end(sym_skip);
 
     if (TCG_TARGET_REG_BITS == 64) {
         tcg_gen_op3_i64(INDEX_op_shl_i64, ret, arg1, arg2);
@@ -1943,9 +2176,12 @@ void tcg_gen_shl_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 
 void tcg_gen_shr_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 {
+    TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
     gen_helper_sym_shift_right_i64(tcgv_i64_expr(ret),
                                    arg1, tcgv_i64_expr(arg1),
                                    arg2, tcgv_i64_expr(arg2));
+    tcg_gen_sym_fast_path_end(sym_skip);
 
     if (TCG_TARGET_REG_BITS == 64) {
         tcg_gen_op3_i64(INDEX_op_shr_i64, ret, arg1, arg2);
@@ -1956,9 +2192,12 @@ void tcg_gen_shr_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 
 void tcg_gen_sar_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
 {
+    TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+        tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
     gen_helper_sym_arithmetic_shift_right_i64(tcgv_i64_expr(ret),
                                               arg1, tcgv_i64_expr(arg1),
                                               arg2, tcgv_i64_expr(arg2));
+    tcg_gen_sym_fast_path_end(sym_skip);
 
     if (TCG_TARGET_REG_BITS == 64) {
         tcg_gen_op3_i64(INDEX_op_sar_i64, ret, arg1, arg2);
@@ -2030,7 +2269,10 @@ void tcg_gen_subi_i64(TCGv_i64 ret, TCGv_i64 arg1, int64_t arg2)
 void tcg_gen_neg_i64(TCGv_i64 ret, TCGv_i64 arg)
 {
     if (TCG_TARGET_REG_BITS == 64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_neg(tcgv_i64_expr(ret), tcgv_i64_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_neg_i64, ret, arg);
     } else {
         TCGv_i32 zero = tcg_constant_i32(0);
@@ -2111,7 +2353,10 @@ void tcg_gen_xori_i64(TCGv_i64 ret, TCGv_i64 arg1, int64_t arg2)
         tcg_gen_mov_i64(ret, arg1);
     } else if (arg2 == -1 && TCG_TARGET_HAS_not_i64) {
         /* Don't recurse with tcg_gen_not_i64.  */
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg1));
         gen_helper_sym_not(tcgv_i64_expr(ret), tcgv_i64_expr(arg1));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_not_i64, ret, arg1);
     } else {
         tcg_gen_xor_i64(ret, arg1, tcg_constant_i64(arg2));
@@ -2209,10 +2454,14 @@ void tcg_gen_brcond_i64(TCGCond cond, TCGv_i64 arg1, TCGv_i64 arg2, TCGLabel *l)
     if (cond == TCG_COND_ALWAYS) {
         tcg_gen_br(l);
     } else if (cond != TCG_COND_NEVER) {
-        /* Generate a setcond for effects in the symbolic backend */
-        TCGv_i64 cond_result_temp = tcg_temp_new_i64();
-        tcg_gen_setcond_i64(cond, cond_result_temp, arg1, arg2);
-        tcg_temp_free_i64(cond_result_temp);
+        /* The helper derives the direction from the concrete operands. */
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            NULL, tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
+        gen_helper_sym_brcond_i64(tcg_sym_pc(),
+                                  arg1, tcgv_i64_expr(arg1),
+                                  arg2, tcgv_i64_expr(arg2),
+                                  tcg_constant_i32(cond));
+        tcg_gen_sym_fast_path_end(sym_skip);
 
         if (TCG_TARGET_REG_BITS == 32) {
             tcg_gen_op6ii_i32(INDEX_op_brcond2_i32, TCGV_LOW(arg1),
@@ -2259,11 +2508,14 @@ void tcg_gen_setcond_i64(TCGCond cond, TCGv_i64 ret,
             tcg_gen_op4i_i64(INDEX_op_setcond_i64, ret, arg1, arg2, cond);
         }
 
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
         gen_helper_sym_setcond_i64(
-            tcgv_i64_expr(ret), tcg_env,
+            tcgv_i64_expr(ret), tcg_sym_pc(),
             arg1, tcgv_i64_expr(arg1),
             arg2, tcgv_i64_expr(arg2),
             tcg_constant_i32(cond), ret);
+        tcg_gen_sym_fast_path_end(sym_skip);
     }
 }
 
@@ -2405,8 +2657,11 @@ void tcg_gen_ext8s_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_ext8s_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_sari_i32(TCGV_HIGH(ret), TCGV_LOW(ret), 31);
     } else if (TCG_TARGET_HAS_ext8s_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_sext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(1));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext8s_i64, ret, arg);
     } else {
         tcg_gen_shli_i64(ret, arg, 56);
@@ -2420,8 +2675,11 @@ void tcg_gen_ext16s_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_ext16s_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_sari_i32(TCGV_HIGH(ret), TCGV_LOW(ret), 31);
     } else if (TCG_TARGET_HAS_ext16s_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_sext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(2));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext16s_i64, ret, arg);
     } else {
         tcg_gen_shli_i64(ret, arg, 48);
@@ -2435,8 +2693,11 @@ void tcg_gen_ext32s_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_mov_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_sari_i32(TCGV_HIGH(ret), TCGV_LOW(ret), 31);
     } else if (TCG_TARGET_HAS_ext32s_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_sext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(4));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext32s_i64, ret, arg);
     } else {
         tcg_gen_shli_i64(ret, arg, 32);
@@ -2450,8 +2711,11 @@ void tcg_gen_ext8u_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_ext8u_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
     } else if (TCG_TARGET_HAS_ext8u_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_zext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(1));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext8u_i64, ret, arg);
     } else {
         tcg_gen_andi_i64(ret, arg, 0xffu);
@@ -2464,8 +2728,11 @@ void tcg_gen_ext16u_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_ext16u_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
     } else if (TCG_TARGET_HAS_ext16u_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_zext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(2));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext16u_i64, ret, arg);
     } else {
         tcg_gen_andi_i64(ret, arg, 0xffffu);
@@ -2478,8 +2745,11 @@ void tcg_gen_ext32u_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_mov_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
     } else if (TCG_TARGET_HAS_ext32u_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_zext(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(4));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_ext32u_i64, ret, arg);
     } else {
         tcg_gen_andi_i64(ret, arg, 0xffffffffu);
@@ -2507,8 +2777,11 @@ void tcg_gen_bswap16_i64(TCGv_i64 ret, TCGv_i64 arg, int flags)
             tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
         }
     } else if (TCG_TARGET_HAS_bswap16_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_bswap(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(2));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op3i_i64(INDEX_op_bswap16_i64, ret, arg, flags);
     } else {
         TCGv_i64 t0 = tcg_temp_ebb_new_i64();
@@ -2559,8 +2832,11 @@ void tcg_gen_bswap32_i64(TCGv_i64 ret, TCGv_i64 arg, int flags)
             tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
         }
     } else if (TCG_TARGET_HAS_bswap32_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_bswap(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(4));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op3i_i64(INDEX_op_bswap32_i64, ret, arg, flags);
     } else {
         TCGv_i64 t0 = tcg_temp_ebb_new_i64();
@@ -2608,8 +2884,11 @@ void tcg_gen_bswap64_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_temp_free_i32(t0);
         tcg_temp_free_i32(t1);
     } else if (TCG_TARGET_HAS_bswap64_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_bswap(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(8));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op3i_i64(INDEX_op_bswap64_i64, ret, arg, 0);
     } else {
         TCGv_i64 t0 = tcg_temp_ebb_new_i64();
@@ -2682,7 +2961,10 @@ void tcg_gen_not_i64(TCGv_i64 ret, TCGv_i64 arg)
         tcg_gen_not_i32(TCGV_LOW(ret), TCGV_LOW(arg));
         tcg_gen_not_i32(TCGV_HIGH(ret), TCGV_HIGH(arg));
     } else if (TCG_TARGET_HAS_not_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_not(tcgv_i64_expr(ret), tcgv_i64_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2_i64(INDEX_op_not_i64, ret, arg);
     } else {
         tcg_gen_xori_i64(ret, arg, -1);
@@ -2956,10 +3238,13 @@ void tcg_gen_deposit_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2,
         return;
     }
     if (TCG_TARGET_HAS_deposit_i64 && TCG_TARGET_deposit_i64_valid(ofs, len)) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
         gen_helper_sym_deposit_i64(tcgv_i64_expr(ret),
                                    arg1, tcgv_i64_expr(arg1),
                                    arg2, tcgv_i64_expr(arg2),
                                    tcg_constant_i64(ofs), tcg_constant_i64(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op5ii_i64(INDEX_op_deposit_i64, ret, arg1, arg2, ofs, len);
         return;
     }
@@ -3022,10 +3307,13 @@ void tcg_gen_deposit_z_i64(TCGv_i64 ret, TCGv_i64 arg,
     } else if (TCG_TARGET_HAS_deposit_i64
                && TCG_TARGET_deposit_i64_valid(ofs, len)) {
         TCGv_i64 zero = tcg_constant_i64(0);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(zero), tcgv_i64_expr(arg));
         gen_helper_sym_deposit_i64(tcgv_i64_expr(ret),
                                    zero, tcgv_i64_expr(zero),
                                    arg, tcgv_i64_expr(arg),
                                    tcg_constant_i64(ofs), tcg_constant_i64(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op5ii_i64(INDEX_op_deposit_i64, ret, zero, arg, ofs, len);
     } else {
         if (TCG_TARGET_REG_BITS == 32) {
@@ -3132,8 +3420,11 @@ void tcg_gen_extract_i64(TCGv_i64 ret, TCGv_i64 arg,
 
     if (TCG_TARGET_HAS_extract_i64
         && TCG_TARGET_extract_i64_valid(ofs, len)) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_extract_i64(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(ofs), tcg_constant_i64(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op4ii_i64(INDEX_op_extract_i64, ret, arg, ofs, len);
         return;
     }
@@ -3240,8 +3531,11 @@ void tcg_gen_sextract_i64(TCGv_i64 ret, TCGv_i64 arg,
 
     if (TCG_TARGET_HAS_sextract_i64
         && TCG_TARGET_extract_i64_valid(ofs, len)) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_sextract_i64(
             tcgv_i64_expr(ret), tcgv_i64_expr(arg), tcg_constant_i64(ofs), tcg_constant_i64(len));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op4ii_i64(INDEX_op_sextract_i64, ret, arg, ofs, len);
         return;
     }
@@ -3312,11 +3606,14 @@ void tcg_gen_extract2_i64(TCGv_i64 ret, TCGv_i64 al, TCGv_i64 ah,
     } else if (al == ah) {
         tcg_gen_rotri_i64(ret, al, ofs);
     } else if (TCG_TARGET_HAS_extract2_i64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i64_expr(ah), tcgv_i64_expr(al));
         gen_helper_sym_extract2_i64(
             tcgv_i64_expr(ret),
             ah, tcgv_i64_expr(ah),
             al, tcgv_i64_expr(al),
             tcg_constant_i64(ofs));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op4i_i64(INDEX_op_extract2_i64, ret, al, ah, ofs);
     } else {
         TCGv_i64 t0 = tcg_temp_ebb_new_i64();
@@ -3334,14 +3631,19 @@ void tcg_gen_movcond_i64(TCGCond cond, TCGv_i64 ret, TCGv_i64 c1,
     } else if (cond == TCG_COND_NEVER) {
         tcg_gen_mov_i64(ret, v2);
     } else if (TCG_TARGET_REG_BITS == 64) {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret),
+            tcgv_i64_expr(c1), tcgv_i64_expr(c2),
+            tcgv_i64_expr(v1), tcgv_i64_expr(v2));
         gen_helper_sym_movcond_i64(
-                tcgv_i64_expr(ret), tcg_env,
+                tcgv_i64_expr(ret), tcg_sym_pc(),
                 c1, tcgv_i64_expr(c1),
                 c2, tcgv_i64_expr(c2),
                 v1, tcgv_i64_expr(v1),
                 v2, tcgv_i64_expr(v2),
                 tcg_constant_i32(cond),
                 ret);
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op6i_i64(INDEX_op_movcond_i64, ret, c1, c2, v1, v2, cond);
     } else {
         TCGv_i32 t0 = tcg_temp_ebb_new_i32();
@@ -3411,9 +3713,12 @@ void tcg_gen_mulu2_i64(TCGv_i64 rl, TCGv_i64 rh, TCGv_i64 arg1, TCGv_i64 arg2)
      */
         TCGv_i64 t0 = tcg_temp_ebb_new_i64();
         tcg_gen_mul_i64(t0, arg1, arg2);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(rh), tcgv_i64_expr(arg1), tcgv_i64_expr(arg2));
         gen_helper_sym_muluh_i64(tcgv_i64_expr(rh),
                                  arg1, tcgv_i64_expr(arg1),
                                  arg2, tcgv_i64_expr(arg2));
+        tcg_gen_sym_fast_path_end(sym_skip);
         gen_helper_muluh_i64(rh, arg1, arg2);
         tcg_gen_mov_i64(rl, t0);
         tcg_temp_free_i64(t0);
@@ -3515,7 +3820,10 @@ void tcg_gen_extrl_i64_i32(TCGv_i32 ret, TCGv_i64 arg)
         tcg_gen_op2(INDEX_op_extrl_i64_i32,
                     tcgv_i32_arg(ret), tcgv_i64_arg(arg));
     } else {*/
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i64_expr(arg));
         gen_helper_sym_trunc_i64_i32(tcgv_i32_expr(ret), tcgv_i64_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         /* We don't want symbolic handling of this mov. */
         tcg_gen_mov_i32_concrete(ret, (TCGv_i32)arg);
     /* } */
@@ -3531,7 +3839,10 @@ void tcg_gen_extrh_i64_i32(TCGv_i32 ret, TCGv_i64 arg)
     } else {*/
         TCGv_i64 t = tcg_temp_ebb_new_i64();
         tcg_gen_shri_i64(t, arg, 32);
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i32_expr(ret), tcgv_i64_expr(t));
         gen_helper_sym_trunc_i64_i32(tcgv_i32_expr(ret), tcgv_i64_expr(t));
+        tcg_gen_sym_fast_path_end(sym_skip);
         /* We don't want symbolic handling of this mov. */
         tcg_gen_mov_i32_concrete(ret, (TCGv_i32)t);
         tcg_temp_free_i64(t);
@@ -3544,7 +3855,10 @@ void tcg_gen_extu_i32_i64(TCGv_i64 ret, TCGv_i32 arg)
         tcg_gen_mov_i32(TCGV_LOW(ret), arg);
         tcg_gen_movi_i32(TCGV_HIGH(ret), 0);
     } else {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_zext_i32_i64(tcgv_i64_expr(ret), tcgv_i32_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2(INDEX_op_extu_i32_i64,
                     tcgv_i64_arg(ret), tcgv_i32_arg(arg));
     }
@@ -3556,7 +3870,10 @@ void tcg_gen_ext_i32_i64(TCGv_i64 ret, TCGv_i32 arg)
         tcg_gen_mov_i32(TCGV_LOW(ret), arg);
         tcg_gen_sari_i32(TCGV_HIGH(ret), TCGV_LOW(ret), 31);
     } else {
+        TCGSymFastPath *sym_skip = SYM_FAST_PATH_BEGIN(
+            tcgv_i64_expr(ret), tcgv_i32_expr(arg));
         gen_helper_sym_sext_i32_i64(tcgv_i64_expr(ret), tcgv_i32_expr(arg));
+        tcg_gen_sym_fast_path_end(sym_skip);
         tcg_gen_op2(INDEX_op_ext_i32_i64,
                     tcgv_i64_arg(ret), tcgv_i32_arg(arg));
     }
@@ -3654,6 +3971,35 @@ void tcg_gen_st_i128(TCGv_i128 val, TCGv_ptr base, tcg_target_long offset)
 
 /* QEMU specific operations.  */
 
+/*
+ * Let the symbolic backend collect garbage every SYM_GC_INTERVAL TB exits.
+ * The backend only collects once enough expressions have been allocated, so
+ * calling it on every exit mostly costs a helper call; a countdown in the
+ * CPU state keeps the common case inline. The ops are not instrumented, and
+ * nothing may be live across the label, which is why this is emitted right
+ * in front of the exit ops.
+ */
+static void gen_sym_collect_garbage(void)
+{
+    int ofs = offsetof(CPUNegativeOffsetState, sym_gc_countdown) -
+              sizeof(CPUNegativeOffsetState);
+    TCGLabel *skip = gen_new_label();
+    TCGv_i32 t = tcg_temp_ebb_new_i32();
+
+    tcg_gen_op3(INDEX_op_ld_i32, tcgv_i32_arg(t), tcgv_ptr_arg(tcg_env), ofs);
+    tcg_gen_op3_i32(INDEX_op_sub_i32, t, t, tcg_constant_i32(1));
+    tcg_gen_op3(INDEX_op_st_i32, tcgv_i32_arg(t), tcgv_ptr_arg(tcg_env), ofs);
+    tcg_gen_op4ii_i32(INDEX_op_brcond_i32, t, tcg_constant_i32(0),
+                      TCG_COND_GT, label_arg(skip));
+    add_last_as_label_use(skip);
+    tcg_temp_free_i32(t);
+
+    tcg_gen_op3(INDEX_op_st_i32, tcgv_i32_arg(tcg_constant_i32(SYM_GC_INTERVAL)),
+                tcgv_ptr_arg(tcg_env), ofs);
+    gen_helper_sym_collect_garbage();
+    gen_set_label(skip);
+}
+
 void tcg_gen_exit_tb(const TranslationBlock *tb, unsigned idx)
 {
     /*
@@ -3682,7 +4028,7 @@ void tcg_gen_exit_tb(const TranslationBlock *tb, unsigned idx)
         tcg_debug_assert(idx == TB_EXIT_REQUESTED);
     }
 
-    gen_helper_sym_collect_garbage();
+    gen_sym_collect_garbage();
     tcg_gen_op1i(INDEX_op_exit_tb, val);
 }
 
@@ -3698,7 +4044,7 @@ void tcg_gen_goto_tb(unsigned idx)
     tcg_ctx->goto_tb_issue_mask |= 1 << idx;
 #endif
     plugin_gen_disable_mem_helpers();
-    gen_helper_sym_collect_garbage();
+    gen_sym_collect_garbage();
     tcg_gen_op1i(INDEX_op_goto_tb, idx);
 }
 
@@ -3712,9 +4058,10 @@ void tcg_gen_lookup_and_goto_ptr(void)
     }
 
     plugin_gen_disable_mem_helpers();
+    /* Before the lookup: ptr must not be live across the label. */
+    gen_sym_collect_garbage();
     ptr = tcg_temp_ebb_new_ptr();
     gen_helper_lookup_tb_ptr(ptr, tcg_env);
-    gen_helper_sym_collect_garbage();
     tcg_gen_op1i(INDEX_op_goto_ptr, tcgv_ptr_arg(ptr));
     tcg_temp_free_ptr(ptr);
 }
@@ -1512,6 +1512,7 @@ void tcg_func_start(TCGContext *s)
     QTAILQ_INIT(&s->free_ops);
     s->emit_before_op = NULL;
     QSIMPLEQ_INIT(&s->labels);
+    s->sym_vec_scratch_used = 0;
 
     tcg_debug_assert(s->addr_type == TCG_TYPE_I32 ||
                      s->addr_type == TCG_TYPE_I64);
@@ -1694,9 +1695,21 @@ TCGTemp *tcg_temp_new_internal(TCGType type, TCGTempKind kind)
 {
     TCGContext *s = tcg_ctx;
     TCGTemp *ts, *ts_expr;
+    bool promote_ebb = false;
     int n;
 
-    if (kind == TEMP_EBB) {
+    /*
+     * The symbolic fast path branches around helper calls, which places
+     * labels in the middle of what the front end considers an extended
+     * basic block. EBB temps would not survive those labels, so give them
+     * TB lifetime; they are still recycled through free_temps.
+     */
+    if (kind == TEMP_EBB && s->sym_fast_path) {
+        kind = TEMP_TB;
+        promote_ebb = true;
+    }
+
+    if (kind == TEMP_EBB || promote_ebb) {
         int idx = find_first_bit(s->free_temps[type].l, TCG_MAX_TEMPS);
 
         if (idx < TCG_MAX_TEMPS) {
@@ -1741,6 +1754,7 @@ TCGTemp *tcg_temp_new_internal(TCGType type, TCGTempKind kind)
     ts->base_type = type;
     ts->temp_allocated = 1;
     ts->kind = kind;
+    ts->sym_promoted_ebb = promote_ebb;
 
     // To change if subindex can take bigger values
     tcg_debug_assert(n >= 0 && n - 1 <= 1);
@@ -1876,9 +1890,14 @@ void tcg_temp_free_internal(TCGTemp *ts)
 
     switch (ts->kind) {
     case TEMP_CONST:
-    case TEMP_TB:
         /* Silently ignore free. */
         break;
+    case TEMP_TB:
+        if (!ts->sym_promoted_ebb) {
+            /* Silently ignore free. */
+            break;
+        }
+        /* fall through */
     case TEMP_EBB:
         tcg_debug_assert(ts->temp_allocated != 0);
         ts->temp_allocated = 0;
@@ -2337,6 +2356,19 @@ bool tcg_op_supported(TCGOpcode op)
 
 static TCGOp *tcg_op_alloc(TCGOpcode opc, unsigned nargs);
 
+/*
+ * In the concrete clone of a TB (CF_SYM_CONCRETE), no symbolic data can flow,
+ * so symbolic helpers are dropped and their result expression is NULL. The
+ * helper declarations opt in through their call flags; the others stay: stores
+ * still have to clear shadow memory, the call stack of the backend must stay
+ * balanced, and loads have to verify that they read concrete data.
+ */
+static bool sym_helper_dropped(const TCGHelperInfo *info)
+{
+    return info->flags & (TCG_CALL_SYM_NULL_PRESERVING |
+                          TCG_CALL_SYM_CONCRETE_DROP);
+}
+
 static void tcg_gen_callN(void *func, TCGHelperInfo *info,
                           TCGTemp *ret, TCGTemp **args)
 {
@@ -2352,6 +2384,14 @@ static void tcg_gen_callN(void *func, TCGHelperInfo *info,
                         temp_tcgv_i64(tcg_constant_internal(TCG_TYPE_I64, 0)));
     }
 
+    if (tcg_ctx->sym_concrete_tb && sym_helper_dropped(info)) {
+        if (ret != NULL) {
+            tcg_gen_mov_i64_concrete(temp_tcgv_i64(ret),
+                        temp_tcgv_i64(tcg_constant_internal(TCG_TYPE_I64, 0)));
+        }
+        return;
+    }
+
     if (unlikely(g_once_init_enter(HELPER_INFO_INIT(info)))) {
         init_call_layout(info);
         g_once_init_leave(HELPER_INFO_INIT(info), HELPER_INFO_INIT_VAL(info));
@@ -3731,6 +3771,200 @@ liveness_pass_0(TCGContext *s)
     }
 }
 
+/*
+ * SymQEMU: some symbolic helpers both build an expression and push a path
+ * constraint, so they cannot be marked TCG_CALL_NO_SIDE_EFFECTS. When the
+ * expression they return is dead, only the constraint is needed; the call is
+ * then replaced by a helper that pushes the same constraint from a subset of
+ * the original arguments.
+ */
+typedef struct SymConstraintOnly {
+    const TCGHelperInfo *full;
+    TCGHelperInfo *reduced;
+    /* For each argument of @reduced, the argument of @full it comes from. */
+    uint8_t args[MAX_CALL_IARGS];
+} SymConstraintOnly;
+
+static const SymConstraintOnly sym_constraint_only[] = {
+    { &helper_info_sym_setcond_i32, &helper_info_sym_brcond_i32,
+      { 0, 1, 2, 3, 4, 5 } },
+    { &helper_info_sym_setcond_i64, &helper_info_sym_brcond_i64,
+      { 0, 1, 2, 3, 4, 5 } },
+    { &helper_info_sym_movcond_i32, &helper_info_sym_brcond_i32,
+      { 0, 1, 2, 3, 4, 9 } },
+    { &helper_info_sym_movcond_i64, &helper_info_sym_brcond_i64,
+      { 0, 1, 2, 3, 4, 9 } },
+    { &helper_info_sym_load_guest_i32, &helper_info_sym_address_constraint,
+      { 5, 1, 2 } },
+    { &helper_info_sym_load_guest_i64, &helper_info_sym_address_constraint,
+      { 5, 1, 2 } },
+};
+
+/* Rewrite @op in place if it is listed above; its only output is dead. */
+static bool sym_drop_dead_expression(TCGOp *op)
+{
+    const TCGHelperInfo *info = tcg_call_info(op);
+    TCGArg in[ARRAY_SIZE(info->in)];
+    int nb_iargs = TCGOP_CALLI(op);
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(sym_constraint_only); i++) {
+        const SymConstraintOnly *c = &sym_constraint_only[i];
+        TCGHelperInfo *reduced = c->reduced;
+
+        if (info != c->full) {
+            continue;
+        }
+        if (unlikely(g_once_init_enter(HELPER_INFO_INIT(reduced)))) {
+            init_call_layout(reduced);
+            g_once_init_leave(HELPER_INFO_INIT(reduced),
+                              HELPER_INFO_INIT_VAL(reduced));
+        }
+
+        memcpy(in, &op->args[1], nb_iargs * sizeof(TCGArg));
+        for (j = 0; j < reduced->nr_in; j++) {
+            const TCGCallArgumentLoc *loc = &reduced->in[j];
+            int k;
+
+            /* Find the op input holding the same piece of the argument. */
+            for (k = 0; k < nb_iargs; k++) {
+                if (info->in[k].arg_idx == c->args[loc->arg_idx] &&
+                    info->in[k].tmp_subindex == loc->tmp_subindex) {
+                    break;
+                }
+            }
+            tcg_debug_assert(k < nb_iargs);
+            op->args[j] = in[k];
+        }
+        op->args[reduced->nr_in] = (uintptr_t)reduced->func;
+        op->args[reduced->nr_in + 1] = (uintptr_t)reduced;
+        TCGOP_CALLO(op) = 0;
+        TCGOP_CALLI(op) = reduced->nr_in;
+        return true;
+    }
+    return false;
+}
+
+/* Number of ops sym_temp_read_later follows before assuming a read. */
+#define SYM_READ_LATER_OPS  256
+
+/*
+ * Whether the TB temp @ts may be read after @op before being overwritten.
+ * Liveness keeps TB temps in memory (TS_DEAD | TS_MEM) at every basic block
+ * end, which is where the sym-fast-path branches leave the outputs of the
+ * symbolic helpers; follow the control flow for a bounded number of ops.
+ * @plabel_ops caches the set_label op of each label for the current pass.
+ */
+static bool sym_temp_read_later(TCGContext *s, TCGOp *op, TCGTemp *ts,
+                                TCGOp ***plabel_ops)
+{
+    TCGOp **label_ops = *plabel_ops;
+    TCGOp **pending;
+    bool *queued;
+    int nb_pending = 0, budget = SYM_READ_LATER_OPS;
+
+    if (label_ops == NULL) {
+        TCGOp *o;
+
+        label_ops = tcg_malloc(sizeof(TCGOp *) * s->nb_labels);
+        memset(label_ops, 0, sizeof(TCGOp *) * s->nb_labels);
+        QTAILQ_FOREACH(o, &s->ops, link) {
+            if (o->opc == INDEX_op_set_label) {
+                label_ops[arg_label(o->args[0])->id] = o;
+            }
+        }
+        *plabel_ops = label_ops;
+    }
+
+    /* Each label is queued at most once, plus the path starting at @op. */
+    pending = tcg_malloc(sizeof(TCGOp *) * (s->nb_labels + 1));
+    queued = tcg_malloc(s->nb_labels);
+    memset(queued, 0, s->nb_labels);
+    pending[nb_pending++] = QTAILQ_NEXT(op, link);
+
+    while (nb_pending > 0) {
+        TCGOp *o;
+
+        for (o = pending[--nb_pending]; o; o = QTAILQ_NEXT(o, link)) {
+            const TCGOpDef *def = &tcg_op_defs[o->opc];
+            TCGLabel *target = NULL;
+            int nb_oargs, nb_iargs, i;
+            bool killed = false;
+
+            if (--budget < 0) {
+                return true;
+            }
+            if (o->opc == INDEX_op_call) {
+                nb_oargs = TCGOP_CALLO(o);
+                nb_iargs = TCGOP_CALLI(o);
+            } else {
+                nb_oargs = def->nb_oargs;
+                nb_iargs = def->nb_iargs;
+            }
+            for (i = nb_oargs; i < nb_oargs + nb_iargs; i++) {
+                if (arg_temp(o->args[i]) == ts) {
+                    return true;
+                }
+            }
+            for (i = 0; i < nb_oargs; i++) {
+                killed |= arg_temp(o->args[i]) == ts;
+            }
+            /* TB temps do not survive the end of the TB. */
+            if (killed || (def->flags & TCG_OPF_BB_EXIT)) {
+                break;
+            }
+
+            switch (o->opc) {
+            case INDEX_op_set_label:
+                /* Falling into a label that is already queued. */
+                if (queued[arg_label(o->args[0])->id]) {
+                    goto next_path;
+                }
+                queued[arg_label(o->args[0])->id] = true;
+                continue;
+            case INDEX_op_br:
+                target = arg_label(o->args[0]);
+                break;
+            case INDEX_op_brcond_i32:
+            case INDEX_op_brcond_i64:
+                target = arg_label(o->args[3]);
+                break;
+            case INDEX_op_brcond2_i32:
+                target = arg_label(o->args[5]);
+                break;
+            default:
+                continue;
+            }
+
+            if (!queued[target->id] && label_ops[target->id]) {
+                queued[target->id] = true;
+                pending[nb_pending++] = QTAILQ_NEXT(label_ops[target->id],
+                                                    link);
+            }
+            if (o->opc == INDEX_op_br) {
+                break;
+            }
+        }
+    next_path:
+        ;
+    }
+    return false;
+}
+
+/* Whether @ts, the expression output of the call @op, is never used. */
+static bool sym_expression_dead(TCGContext *s, TCGOp *op, TCGTemp *ts,
+                                TCGOp ***plabel_ops)
+{
+    if (!ts->symbolic_expression || !(ts->state & TS_DEAD)) {
+        return false;
+    }
+    if (!(ts->state & TS_MEM)) {
+        return true;
+    }
+    /* Globals are observable in memory; TB temps only if read again. */
+    return ts->kind == TEMP_TB && !sym_temp_read_later(s, op, ts, plabel_ops);
+}
+
 /* Liveness analysis : update the opc_arg_life array to tell if a
    given input arguments is dead. Instructions updating dead
    temporaries are removed. */
@@ -3740,6 +3974,7 @@ liveness_pass_1(TCGContext *s)
     int nb_globals = s->nb_globals;
     int nb_temps = s->nb_temps;
     TCGOp *op, *op_prev;
+    TCGOp **sym_label_ops = NULL;
     TCGRegSet *prefs;
     int i;
 
@@ -3763,9 +3998,18 @@ liveness_pass_1(TCGContext *s)
         switch (opc) {
         case INDEX_op_call:
             {
-                const TCGHelperInfo *info = tcg_call_info(op);
-                int call_flags = tcg_call_flags(op);
+                const TCGHelperInfo *info;
+                int call_flags;
+
+                /* Dead symbolic expression: keep only its path constraint. */
+                if (TCGOP_CALLO(op) == 1 &&
+                    sym_expression_dead(s, op, arg_temp(op->args[0]),
+                                        &sym_label_ops)) {
+                    sym_drop_dead_expression(op);
+                }
 
+                info = tcg_call_info(op);
+                call_flags = tcg_call_flags(op);
                 nb_oargs = TCGOP_CALLO(op);
                 nb_iargs = TCGOP_CALLI(op);
 
@@ -6262,6 +6506,9 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
 #endif
 
     tcg_optimize(s);
+    if (s->sym_fuse) {
+        tcg_sym_fuse(s);
+    }
 
     reachable_code_pass(s);
     liveness_pass_0(s);
@@ -0,0 +1,261 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Solver queries with and without calling context
+ *
+ * The workload models a guest that scans symbolic input with a small
+ * character-class function, called in a loop from two call sites. Each
+ * instruction of the guest is translated into a TB of its own with the
+ * generators that the translators use, once without the call/return
+ * notifications (as before the translators emitted them) and once with
+ * them, and the TBs are run on a CPU of their own. Every round translates
+ * the guest at new addresses, so that the coverage state the backend keeps
+ * from earlier runs doesn't carry over, and the order of the two variants
+ * alternates between rounds. The figures are the queries that the runtime
+ * passed to the backend and the new test cases that the backend wrote to
+ * SYMCC_OUTPUT_DIR; the last line of the output compares the two variants.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/units.h"
+#include "tcg/tcg.h"
+#include "tcg/tcg-op.h"
+#include "tcg/startup.h"
+#include "cpu.h"
+#include "exec/helper-proto.h"
+#include "exec/translation-block.h"
+#include "accel/tcg/tcg-runtime-sym-common.h"
+
+#define SymExpr void*
+#include "RuntimeCommon.h"
+
+/* See tests/unit/check-sym-runtime.c. */
+unsigned long guest_base = 0;
+
+#define INPUT_SIZE  256
+#define NB_ROUNDS   4
+#define RUN_BASE    0x400000
+#define RUN_STRIDE  0x100000
+
+/* Guest code layout, relative to the base address of a run */
+#define PC_LOOP         0x100   /* loop over the input */
+#define PC_CALL_KEY     0x110   /* call is_space for a key byte */
+#define PC_CALL_VALUE   0x120   /* call is_space for a value byte */
+#define PC_IS_SPACE     0x200   /* entry of is_space: branch on c == ' ' */
+#define PC_IS_SPACE_RET 0x208   /* return of is_space */
+#define CALL_INSN_LEN   4
+
+static const uint64_t call_sites[] = { PC_CALL_KEY, PC_CALL_VALUE };
+
+/* The host code of the guest, translated at some base address */
+typedef struct SymContextGuest {
+    uint64_t base;
+    const void *loop;
+    const void *call[ARRAY_SIZE(call_sites)];
+    const void *is_space;
+    const void *ret;
+} SymContextGuest;
+
+typedef struct SymContextStats {
+    const char *name;
+    size_t branches;
+    uint64_t queries;
+    size_t test_cases;
+    double time;
+} SymContextStats;
+
+static X86CPU *cpu;
+static TCGv_i64 cpu_char;       /* argument of is_space, in RAX */
+static TCGv_i64 cpu_ret_addr;   /* return address, in RCX */
+static void **cpu_char_expr;
+
+static void guest_setup(void)
+{
+    TCGTemp *char_expr;
+
+    tcg_init(32 * MiB, 0, 1,
+             offsetof(ArchCPU, env_exprs) - offsetof(ArchCPU, env));
+    tcg_prologue_init();
+    tcg_ctx->addr_type = TCG_TYPE_I64;
+    tcg_ctx->insn_start_words = TARGET_INSN_START_WORDS;
+
+    cpu = g_new0(X86CPU, 1);
+    current_cpu = &cpu->parent_obj;
+    cpu_char = tcg_global_mem_new_i64(tcg_env,
+                                      offsetof(CPUX86State, regs[R_EAX]),
+                                      "rax");
+    cpu_ret_addr = tcg_global_mem_new_i64(tcg_env,
+                                          offsetof(CPUX86State, regs[R_ECX]),
+                                          "rcx");
+    char_expr = tcgv_ptr_temp(tcgv_i64_expr(cpu_char));
+    cpu_char_expr = (void **)((char *)&cpu->env + char_expr->mem_offset);
+}
+
+/* Start a TB for the guest instruction at @pc, as gen_tb_start does. */
+static void insn_start(uint64_t pc)
+{
+    tcg_func_start(tcg_ctx);
+    tcg_gen_sym_notify_block(pc);
+    tcg_ctx->sym_insn_pc = pc;
+    tcg_gen_insn_start(pc, 0);
+}
+
+/* Generate the host code of the TB started at @pc. */
+static const void *insn_end(uint64_t pc)
+{
+    TranslationBlock *tb = tcg_tb_alloc(tcg_ctx);
+    int size;
+
+    tcg_gen_exit_tb(NULL, 0);
+    tb->tc.ptr = tcg_splitwx_to_rx(tcg_ctx->code_gen_ptr);
+    tb->cflags = 1;
+    tb->icount = 1;
+    tcg_ctx->gen_tb = tb;
+    size = tcg_gen_code(tcg_ctx, tb, pc);
+    g_assert_cmpint(size, >, 0);
+    tcg_ctx->gen_tb = NULL;
+    tcg_ctx->code_gen_ptr = (void *)ROUND_UP(
+        (uintptr_t)tcg_ctx->code_gen_ptr + size, CODE_GEN_ALIGN);
+    return tb->tc.ptr;
+}
+
+static void translate(SymContextGuest *guest, uint64_t base,
+                      bool notify_context)
+{
+    TCGLabel *done;
+
+    guest->base = base;
+
+    insn_start(base + PC_LOOP);
+    guest->loop = insn_end(base + PC_LOOP);
+
+    for (int i = 0; i < ARRAY_SIZE(call_sites); i++) {
+        uint64_t pc = base + call_sites[i];
+
+        insn_start(pc);
+        if (notify_context) {
+            tcg_gen_sym_notify_call(tcg_constant_i64(pc + CALL_INSN_LEN));
+        }
+        guest->call[i] = insn_end(pc);
+    }
+
+    insn_start(base + PC_IS_SPACE);
+    done = gen_new_label();
+    tcg_gen_brcondi_i64(TCG_COND_EQ, cpu_char, ' ', done);
+    gen_set_label(done);
+    guest->is_space = insn_end(base + PC_IS_SPACE);
+
+    insn_start(base + PC_IS_SPACE_RET);
+    if (notify_context) {
+        tcg_gen_sym_notify_return(cpu_ret_addr);
+    }
+    guest->ret = insn_end(base + PC_IS_SPACE_RET);
+}
+
+static size_t count_test_cases(void)
+{
+    const char *dir_name = g_getenv("SYMCC_OUTPUT_DIR");
+    GDir *dir;
+    size_t count = 0;
+
+    if (dir_name == NULL) {
+        return 0;
+    }
+    dir = g_dir_open(dir_name, 0, NULL);
+    if (dir == NULL) {
+        return 0;
+    }
+    while (g_dir_read_name(dir)) {
+        count++;
+    }
+    g_dir_close(dir);
+    return count;
+}
+
+static void run(const SymContextGuest *guest, SymContextStats *stats)
+{
+    size_t test_cases = count_test_cases();
+    uint64_t queries = *sym_query_counter;
+
+    g_test_timer_start();
+    for (size_t i = 0; i < INPUT_SIZE; i += ARRAY_SIZE(call_sites)) {
+        tcg_qemu_tb_exec(&cpu->env, guest->loop);
+        for (int site = 0; site < ARRAY_SIZE(call_sites); site++) {
+            /* The caller loads the input byte and the callee returns. */
+            cpu->env.regs[R_EAX] = 'a';
+            *cpu_char_expr = _sym_build_zext(
+                _sym_get_input_byte(i + site, 'a'), 56);
+            cpu->env.regs[R_ECX] =
+                guest->base + call_sites[site] + CALL_INSN_LEN;
+
+            tcg_qemu_tb_exec(&cpu->env, guest->call[site]);
+            tcg_qemu_tb_exec(&cpu->env, guest->is_space);
+            tcg_qemu_tb_exec(&cpu->env, guest->ret);
+        }
+    }
+    stats->time += g_test_timer_elapsed();
+    stats->branches += INPUT_SIZE;
+    stats->queries += *sym_query_counter - queries;
+    stats->test_cases += count_test_cases() - test_cases;
+}
+
+static void report(const SymContextStats *stats)
+{
+    g_test_message("%-10s: %4" PRIu64 " queries, %4zu test cases for %zu "
+                   "branches, %8.2f ms", stats->name, stats->queries,
+                   stats->test_cases, stats->branches, stats->time * 1e3);
+}
+
+static void test(void)
+{
+    SymContextStats without = { .name = "no context" };
+    SymContextStats with = { .name = "context" };
+
+    for (size_t round = 0; round < NB_ROUNDS; round++) {
+        uint64_t base = RUN_BASE + round * 2 * RUN_STRIDE;
+        SymContextGuest plain, context;
+
+        translate(&plain, base, false);
+        translate(&context, base + RUN_STRIDE, true);
+        if (round & 1) {
+            run(&context, &with);
+            run(&plain, &without);
+        } else {
+            run(&plain, &without);
+            run(&context, &with);
+        }
+    }
+
+    report(&without);
+    report(&with);
+    g_test_message("%s vs %s: %.2fx queries, %.2fx test cases, %.2fx time",
+                   with.name, without.name,
+                   (double)with.queries / MAX(without.queries, 1),
+                   (double)with.test_cases / MAX(without.test_cases, 1),
+                   with.time / without.time);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    fclose(stdin);              /* for the Qsym backend */
+    _sym_initialize();
+    guest_setup();
+
+    g_test_add_func("/sym/context/scan", test);
+    return g_test_run();
+}
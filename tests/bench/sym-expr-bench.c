@@ -0,0 +1,248 @@
+/*
+ * This file is part of SymQEMU.
+ *
+ * SymQEMU is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * SymQEMU is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * SymQEMU. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Expression size and solver time of the extension and byte-swap helpers
+ *
+ * The workload models a parser of big-endian records read from symbolic
+ * input on a little-endian guest: every field is loaded, byte-swapped and
+ * extended, and a path constraint on the record is checked for feasibility.
+ * It is run with the shift/mask forms that the helpers used to build
+ * (reproduced below) and with the helpers themselves, alternating between the
+ * two over several rounds, and the last line of the output compares them.
+ */
+
+#include "qemu/osdep.h"
+#include "tcg/tcg.h"
+#include "cpu.h"
+#include "exec/helper-proto.h"
+
+#define SymExpr void*
+#include "RuntimeCommon.h"
+
+/* See tests/unit/check-sym-runtime.c. */
+unsigned long guest_base = 0;
+
+#define NB_RECORDS  64
+#define NB_ROUNDS   8
+#define RECORD_SIZE 14          /* be16 type, be32 length, be64 offset */
+
+typedef struct SymExprOps {
+    const char *name;
+    void *(*sext)(void *expr, uint64_t target_length);
+    void *(*zext)(void *expr, uint64_t target_length);
+    void *(*bswap)(void *expr, uint64_t length);
+} SymExprOps;
+
+typedef struct SymExprStats {
+    size_t records;
+    size_t size;
+    double build_time;
+    double solve_time;
+} SymExprStats;
+
+static void *legacy_sext(void *expr, uint64_t target_length)
+{
+    size_t current_bits = _sym_bits_helper(expr);
+    void *shift_distance_expr = _sym_build_integer(
+        current_bits - target_length * 8, current_bits);
+
+    return _sym_build_arithmetic_shift_right(
+        _sym_build_shift_left(expr, shift_distance_expr),
+        shift_distance_expr);
+}
+
+static void *legacy_zext(void *expr, uint64_t target_length)
+{
+    size_t current_bits = _sym_bits_helper(expr);
+
+    return _sym_build_and(
+        expr,
+        _sym_build_integer((1ull << (target_length * 8)) - 1, current_bits));
+}
+
+static void *legacy_bswap(void *expr, uint64_t length)
+{
+    size_t bits = _sym_bits_helper(expr);
+    void *eight = _sym_build_integer(8, bits);
+    void *sixteen = _sym_build_integer(16, bits);
+    void *thirty_two = _sym_build_integer(32, bits);
+    void *forty_eight = _sym_build_integer(48, bits);
+
+    switch (length) {
+    case 2:
+        return _sym_build_or(
+            _sym_build_shift_left(legacy_zext(expr, 1), eight),
+            _sym_build_logical_shift_right(expr, eight));
+    case 4: {
+        void *mask = _sym_build_integer(0x00ff00ff, bits);
+        void *first_block = _sym_build_or(
+            _sym_build_and(_sym_build_logical_shift_right(expr, eight), mask),
+            _sym_build_shift_left(_sym_build_and(expr, mask), eight));
+
+        return _sym_build_or(
+            _sym_build_logical_shift_right(first_block, sixteen),
+            _sym_build_logical_shift_right(
+                _sym_build_shift_left(first_block, forty_eight),
+                thirty_two));
+    }
+    case 8: {
+        void *mask1 = _sym_build_integer(0x00ff00ff00ff00ffull, 64);
+        void *mask2 = _sym_build_integer(0x0000ffff0000ffffull, 64);
+        void *first_block = _sym_build_or(
+            _sym_build_and(_sym_build_logical_shift_right(expr, eight), mask1),
+            _sym_build_shift_left(_sym_build_and(expr, mask1), eight));
+        void *second_block = _sym_build_or(
+            _sym_build_and(
+                _sym_build_logical_shift_right(first_block, sixteen),
+                mask2),
+            _sym_build_shift_left(_sym_build_and(first_block, mask2), sixteen));
+
+        return _sym_build_or(
+            _sym_build_logical_shift_right(second_block, thirty_two),
+            _sym_build_shift_left(second_block, thirty_two));
+    }
+    default:
+        g_assert_not_reached();
+    }
+}
+
+static const SymExprOps legacy_ops = {
+    .name = "shift/mask",
+    .sext = legacy_sext,
+    .zext = legacy_zext,
+    .bswap = legacy_bswap,
+};
+
+static const SymExprOps native_ops = {
+    .name = "native",
+    .sext = helper_sym_sext,
+    .zext = helper_sym_zext,
+    .bswap = helper_sym_bswap,
+};
+
+/* A little-endian guest load of symbolic input, zero-extended to 64 bits. */
+static void *input_load(size_t offset, size_t length)
+{
+    void *expr = _sym_get_input_byte(offset, 0);
+
+    for (size_t i = 1; i < length; i++) {
+        expr = _sym_concat_helper(_sym_get_input_byte(offset + i, 0), expr);
+    }
+    return length == 8 ? expr : _sym_build_zext(expr, 64 - length * 8);
+}
+
+/* type == 1 && length < 0x1000 && offset + length <= 0x10000 */
+static void *record_constraint(const SymExprOps *ops, size_t record)
+{
+    size_t base = record * RECORD_SIZE;
+    void *type = ops->sext(ops->bswap(input_load(base, 2), 2), 2);
+    void *length = ops->zext(ops->bswap(input_load(base + 2, 4), 4), 4);
+    void *offset = ops->bswap(input_load(base + 6, 8), 8);
+
+    return _sym_build_bool_and(
+        _sym_build_equal(type, _sym_build_integer(1, 64)),
+        _sym_build_bool_and(
+            _sym_build_unsigned_less_than(length,
+                                          _sym_build_integer(0x1000, 64)),
+            _sym_build_unsigned_less_equal(
+                _sym_build_add(offset, length),
+                _sym_build_integer(0x10000, 64))));
+}
+
+/* The number of operator applications in the printed form. */
+static size_t expr_size(void *expr)
+{
+    const char *str = _sym_expr_to_string(expr);
+    size_t size = 0;
+
+    for (; *str; str++) {
+        size += *str == '(';
+    }
+    return size;
+}
+
+/* Build and solve the constraints of NB_RECORDS records from @first on. */
+static void run_round(const SymExprOps *ops, size_t first,
+                      SymExprStats *stats)
+{
+    void *constraints[NB_RECORDS];
+
+    g_test_timer_start();
+    for (size_t i = 0; i < NB_RECORDS; i++) {
+        constraints[i] = record_constraint(ops, first + i);
+    }
+    stats->build_time += g_test_timer_elapsed();
+
+    for (size_t i = 0; i < NB_RECORDS; i++) {
+        stats->size += expr_size(constraints[i]);
+    }
+
+    g_test_timer_start();
+    for (size_t i = 0; i < NB_RECORDS; i++) {
+        g_assert_true(_sym_feasible(constraints[i]));
+    }
+    stats->solve_time += g_test_timer_elapsed();
+    stats->records += NB_RECORDS;
+}
+
+static void report(const SymExprOps *ops, const SymExprStats *stats)
+{
+    g_test_message("%-10s: %6.1f ops/record, build %8.2f us/record, "
+                   "solve %8.2f ms/record", ops->name,
+                   (double)stats->size / stats->records,
+                   stats->build_time * 1e6 / stats->records,
+                   stats->solve_time * 1e3 / stats->records);
+}
+
+static void test(void)
+{
+    SymExprStats legacy = { 0 }, native = { 0 };
+
+    /*
+     * Every round uses fresh input bytes, so that nothing is cached, and
+     * the order alternates, so that neither form profits from a warm solver.
+     */
+    for (size_t round = 0; round < NB_ROUNDS; round++) {
+        size_t first = round * 2 * NB_RECORDS;
+
+        if (round & 1) {
+            run_round(&native_ops, first, &native);
+            run_round(&legacy_ops, first + NB_RECORDS, &legacy);
+        } else {
+            run_round(&legacy_ops, first, &legacy);
+            run_round(&native_ops, first + NB_RECORDS, &native);
+        }
+    }
+
+    report(&legacy_ops, &legacy);
+    report(&native_ops, &native);
+    g_test_message("%s vs %s: %.2fx ops, %.2fx build time, %.2fx solve time",
+                   native_ops.name, legacy_ops.name,
+                   (double)native.size / legacy.size,
+                   native.build_time / legacy.build_time,
+                   native.solve_time / legacy.solve_time);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    fclose(stdin);              /* for the Qsym backend */
+    _sym_initialize();
+
+    g_test_add_func("/sym/expr/be-parser", test);
+    return g_test_run();
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+int main(int argc, char *argv[]) {
+
+    if (argc != 2) {
+        puts("ERROR: You need one argument.");
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+
+    if (fd == -1) {
+        puts("ERROR: Could not open file.");
+        return 1;
+    }
+
+    char *input = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    if (input == MAP_FAILED) {
+        puts("ERROR: Could not map file.");
+        return 1;
+    }
+
+    /* Overwrite the second byte through a system call: it is not input anymore. */
+    int zero = open("/dev/zero", O_RDONLY);
+
+    if (zero == -1 || read(zero, input + 1, 1) != 1) {
+        puts("ERROR: Could not read /dev/zero.");
+        return 1;
+    }
+
+    if (input[0] == 'a') {
+        puts("foo1");
+    }
+
+    if (input[1] == 'b') {
+        puts("foo2");
+    }
+
+    if (input[2] == 'c') {
+        puts("foo3");
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+
+int main(int argc, char *argv[]) {
+    char input1, input2, input3, input4, input5;
+    struct iovec vec[2] = {
+        { .iov_base = &input2, .iov_len = 1 },
+        { .iov_base = &input3, .iov_len = 1 },
+    };
+    struct iovec vec5 = { .iov_base = &input5, .iov_len = 1 };
+
+    if (argc != 2) {
+        puts("ERROR: You need one argument.");
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+
+    if (fd == -1) {
+        puts("ERROR: Could not open file.");
+        return 1;
+    }
+
+    /* Byte 3, without moving the file position */
+    if (pread(fd, &input1, 1, 3) != 1) {
+        return 1;
+    }
+
+    /* Bytes 0 and 1 */
+    if (readv(fd, vec, 2) != 2) {
+        return 1;
+    }
+
+    /* Byte 2: read() must continue where readv() stopped */
+    if (read(fd, &input4, 1) != 1) {
+        return 1;
+    }
+
+    /* Byte 4 */
+    if (preadv(fd, &vec5, 1, 4) != 1) {
+        return 1;
+    }
+
+    if (input1 == 'a') {
+        puts("foo1");
+    }
+
+    if (input2 == 'b') {
+        puts("foo2");
+    }
+
+    if (input3 == 'c') {
+        puts("foo3");
+    }
+
+    if (input4 == 'd') {
+        puts("foo4");
+    }
+
+    if (input5 == 'e') {
+        puts("foo5");
+    }
+
+    return 0;
+}
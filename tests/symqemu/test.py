@@ -52,3 +52,9 @@ def test_printf(self):
 
     def test_simple_i128(self):
         self.run_symqemu_and_assert_correct_result('simple_i128')
+
+    def test_pread(self):
+        self.run_symqemu_and_assert_correct_result('pread')
+
+    def test_mmap(self):
+        self.run_symqemu_and_assert_correct_result('mmap')
@@ -15,10 +15,21 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/units.h"
 #include "tcg/tcg.h"
+#include "tcg/tcg-op.h"
+#include "tcg/startup.h"
+#include "tcg/insn-start-words.h"
+#include "tcg/sym-program.h"
+#include "tcg/tcg-internal.h"
 #include "hw/i386/topology.h"
 #include "cpu.h"
 #include "exec/helper-proto.h"
+#include "accel/tcg/tcg-runtime-sym-common.h"
+#include "tcg/sym-page-map.h"
+#include "accel/tcg/internal-common.h"
+#include "accel/tcg/internal-target.h"
+#include "exec/translation-block.h"
 
 #define SymExpr void*
 #include "RuntimeCommon.h"
@@ -263,7 +274,7 @@ static void load_store_guest_test(void)
 
     /* Loading concrete memory should give us a null expression. */
     g_assert_true(helper_sym_load_guest_i64(
-                      &dummy_state, (target_ulong)&memory[16], NULL, 8, 0)
+                      &dummy_state, (target_ulong)&memory[16], NULL, 8, 0, 0)
                   == NULL);
 
     /* Store some symbolic data in the middle of the buffer. */
@@ -272,44 +283,44 @@ static void load_store_guest_test(void)
         &dummy_state,
         0x11223344, _sym_build_integer(0x11223344, 64),
         (target_ulong)&memory[16], NULL,
-        4, 0);
+        4, 0, 0);
 
     *((uint16_t*)&memory[20]) = 0x5566;
     helper_sym_store_guest_i32(
         &dummy_state,
         0x5566, _sym_build_integer(0x5566, 32),
         (target_ulong)&memory[20], NULL,
-        2, 0);
+        2, 0, 0);
 
     /* Buffer: [AA...AA 44 33 22 11 66 55 BB...BB] */
 
     /* Make sure that only the four bytes are symbolic, and that reading partly
      * symbolic data takes the concrete data into account. */
     assert_equal(helper_sym_load_guest_i64(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 1, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 1, 0, 0),
                  0x44, 64);
     assert_equal(helper_sym_load_guest_i64(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 2, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 2, 0, 0),
                  0x3344, 64);
     assert_equal(helper_sym_load_guest_i64(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 4, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 4, 0, 0),
                  0x11223344, 64);
     assert_equal(helper_sym_load_guest_i64(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 8, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 8, 0, 0),
                  0xBBBB556611223344, 64);
 
     assert_equal(helper_sym_load_guest_i32(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 1, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 1, 0, 0),
                  0x44, 32);
     assert_equal(helper_sym_load_guest_i32(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 2, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 2, 0, 0),
                  0x3344, 32);
     assert_equal(helper_sym_load_guest_i32(
-                     &dummy_state, (target_ulong)&memory[16], NULL, 4, 0),
+                     &dummy_state, (target_ulong)&memory[16], NULL, 4, 0, 0),
                  0x11223344, 32);
 
     assert_equal(helper_sym_load_guest_i32(
-                     &dummy_state, (target_ulong)&memory[14], NULL, 4, 0),
+                     &dummy_state, (target_ulong)&memory[14], NULL, 4, 0, 0),
                  0x3344AAAA, 32);
 
     /* Make the backend forget about the symbolic data (just in case). */
@@ -363,10 +374,492 @@ static void muluh_test(void)
     assert_equal(result, 0xAABBCCDD, 64);
 }
 
+static void tcg_setup(void)
+{
+    static bool initialized;
+
+    if (!initialized) {
+        tcg_init(32 * MiB, 0, 1,
+                 offsetof(ArchCPU, env_exprs) - offsetof(ArchCPU, env));
+        tcg_prologue_init();
+        tcg_ctx->addr_type = TCG_TYPE_I64;
+        tcg_ctx->insn_start_words = TARGET_INSN_START_WORDS;
+        initialized = true;
+    }
+}
+
+/* Start translating a fresh TB with the inline fast path enabled. */
+static void fast_path_start(void)
+{
+    tcg_setup();
+    tcg_ctx->sym_fast_path = true;
+    tcg_func_start(tcg_ctx);
+}
+
+/*
+ * Check that the first helper call reading @expr sees it intact, and that the
+ * expression is only cleared after the call, i.e., on the skip path.
+ */
+static void assert_fast_path_keeps_input(TCGTemp *expr)
+{
+    TCGOp *op;
+    bool called = false, cleared = false;
+
+    QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+        if (op->opc == INDEX_op_call && !called) {
+            int nb_oargs = TCGOP_CALLO(op);
+
+            for (int i = nb_oargs; i < nb_oargs + TCGOP_CALLI(op); i++) {
+                called |= op->args[i] && arg_temp(op->args[i]) == expr;
+            }
+        } else if (op->opc == INDEX_op_mov_i64 &&
+                   arg_temp(op->args[0]) == expr) {
+            g_assert_true(called);
+            cleared = true;
+        }
+    }
+    g_assert_true(called);
+    g_assert_true(cleared);
+}
+
+static void fast_path_alias_test(void)
+{
+    TCGv_i64 t0, t1;
+
+    fast_path_start();
+    t0 = tcg_temp_new_i64();
+    t1 = tcg_temp_new_i64();
+
+    /* The result aliases the first input, as in add T0, T0, T1. */
+    tcg_gen_add_i64(t0, t0, t1);
+    assert_fast_path_keeps_input(tcgv_ptr_temp(tcgv_i64_expr(t0)));
+}
+
+static void fast_path_alias_vec_test(void)
+{
+    TCGv_vec v0, v1;
+
+    if (!TCG_TARGET_HAS_v128) {
+        g_test_skip("host has no 128-bit vectors");
+        return;
+    }
+
+    /* Two-operand SSE/NEON forms: the result aliases the first input. */
+    fast_path_start();
+    v0 = tcg_temp_new_vec(TCG_TYPE_V128);
+    v1 = tcg_temp_new_vec(TCG_TYPE_V128);
+    tcg_gen_add_vec(MO_32, v0, v0, v1);
+    assert_fast_path_keeps_input(tcgv_ptr_temp(tcgv_vec_expr(v0)));
+
+    fast_path_start();
+    v0 = tcg_temp_new_vec(TCG_TYPE_V128);
+    tcg_gen_shli_vec(MO_32, v0, v0, 4);
+    assert_fast_path_keeps_input(tcgv_ptr_temp(tcgv_vec_expr(v0)));
+}
+
+/* Garbage collection threshold of the backend in this test (see main). */
+#define SYM_TEST_GC_THRESHOLD 10000
+
+static void constant_cache_test(void)
+{
+    void *expr = sym_build_constant(0xFF, 32);
+
+    /* Constants are shared per value and width. */
+    g_assert_true(sym_build_constant(0xFF, 32) == expr);
+    g_assert_true(sym_build_constant(0xFF, 64) != expr);
+    g_assert_true(sym_build_constant(0xFE, 32) != expr);
+    assert_equal(expr, 0xFF, 32);
+    assert_equal(sym_build_constant(0xFF, 64), 0xFF, 64);
+
+    /*
+     * Cached constants survive garbage collection. The backend only collects
+     * once it holds SYM_TEST_GC_THRESHOLD expressions (see main), so allocate
+     * more than that first.
+     */
+    for (int i = 0; i < 2 * SYM_TEST_GC_THRESHOLD; i++) {
+        _sym_build_integer(i, 32);
+    }
+    _sym_collect_garbage();
+    g_assert_true(sym_build_constant(0xFF, 32) == expr);
+    assert_equal(expr, 0xFF, 32);
+}
+
+static void vector_lanes_test(void)
+{
+    uint32_t memory[4] = { 0x11223344, 0x55667788, 0x99AABBCC, 0xDDEEFF00 };
+    uint32_t mask[4] = { 0xFFFF0000, 0x0000FFFF, 0xFFFF0000, 0x0000FFFF };
+    void *vector, *result;
+
+    /* Make the second element symbolic. */
+    helper_sym_store_host(_sym_build_integer(memory[1], 32), memory, 4, 4);
+    vector = helper_sym_load_host_vec(memory, 0, 16);
+    g_assert_cmphex(sym_vec_symbolic_bytes(vector, 16), ==, 0x00F0);
+
+    /* Bitwise operations keep the symbolic bytes of their operands. */
+    result = helper_sym_and_vec(memory, vector, mask, NULL, 128, MO_32);
+    g_assert_cmpint(_sym_bits_helper(result), ==, 128);
+    g_assert_cmphex(sym_vec_symbolic_bytes(result, 16), ==, 0x00F0);
+    assert_equal(_sym_extract_helper(result, 63, 32), 0x7788, 32);
+
+    /* Element-wise operations extend them to whole elements. */
+    result = helper_sym_add_vec(memory, vector, mask, NULL, 128, MO_64);
+    g_assert_cmphex(sym_vec_symbolic_bytes(result, 16), ==, 0x00FF);
+    assert_equal(_sym_extract_helper(result, 63, 0),
+                 0x5566778811223344ull + 0x0000FFFFFFFF0000ull, 64);
+    assert_equal(_sym_extract_helper(result, 127, 64),
+                 0xDDEEFF0099AABBCCull + 0x0000FFFFFFFF0000ull, 64);
+
+    result = helper_sym_shift_left_vec_int32(memory, vector, 4, NULL,
+                                             128, MO_16);
+    g_assert_cmphex(sym_vec_symbolic_bytes(result, 16), ==, 0x00F0);
+    assert_equal(_sym_extract_helper(result, 47, 32), 0x7880, 16);
+
+    /* Make the backend forget about the symbolic data (just in case). */
+    _sym_write_memory((uint8_t *)memory, sizeof(memory), NULL, false);
+}
+
+static void page_map_test(void)
+{
+    uint64_t page = 0x1234ull << SYM_PAGE_BITS;
+
+    g_assert_false(sym_page_map_test(page));
+    sym_page_map_mark(page + 0xFFC, 8);
+
+    /* The range and the page in front of it are marked... */
+    g_assert_true(sym_page_map_test(page - 1));
+    g_assert_true(sym_page_map_test(page));
+    g_assert_true(sym_page_map_test(page + 0x1000));
+    g_assert_false(sym_page_map_test(page + 0x2000));
+
+    /* ...and so are the pages that alias with them. */
+    g_assert_true(sym_page_map_test(
+        page + ((uint64_t)SYM_PAGE_MAP_SIZE << SYM_PAGE_BITS)));
+}
+
+static void branch_budget_test(void)
+{
+    static const SymBranchAction expected[] = {
+        SYM_BRANCH_QUERY, SYM_BRANCH_QUERY, SYM_BRANCH_SKIP, SYM_BRANCH_QUERY,
+        SYM_BRANCH_SKIP, SYM_BRANCH_SKIP, SYM_BRANCH_SKIP, SYM_BRANCH_QUERY,
+    };
+    uint64_t pc = 0x401234;
+
+    /* The first two occurrences, then new powers of two only. */
+    sym_branch_budget = 2;
+    for (int i = 0; i < ARRAY_SIZE(expected); i++) {
+        g_assert_cmpint(sym_branch_site_visit(pc), ==, expected[i]);
+    }
+
+    /* Without a budget, every occurrence is queried. */
+    sym_branch_budget = 0;
+    g_assert_cmpint(sym_branch_site_visit(pc), ==, SYM_BRANCH_QUERY);
+}
+
+static void query_counter_test(void)
+{
+    void *constraint = _sym_build_equal(_sym_get_input_byte(0, 'a'),
+                                        _sym_build_integer('b', 8));
+    uint64_t queries = *sym_query_counter;
+
+    /* Skipped constraints never reach the backend. */
+    sym_push_path_constraint(SYM_BRANCH_QUERY, constraint, false, 0x401000);
+    g_assert_cmpuint(*sym_query_counter, ==, queries + 1);
+    sym_push_path_constraint(SYM_BRANCH_SKIP, constraint, false, 0x401004);
+    g_assert_cmpuint(*sym_query_counter, ==, queries + 1);
+    sym_push_path_constraint(SYM_BRANCH_QUERY, constraint, false, 0x401008);
+    g_assert_cmpuint(*sym_query_counter, ==, queries + 2);
+}
+
+/* Translate neg with the input expression set to @value, then optimize. */
+static int optimized_neg_calls(int64_t value)
+{
+    TCGv_i64 in, out;
+    TCGOp *op;
+    int calls = 0;
+
+    tcg_setup();
+    tcg_ctx->sym_fast_path = false;
+    tcg_func_start(tcg_ctx);
+
+    in = tcg_temp_new_i64();
+    out = tcg_temp_new_i64();
+    tcg_gen_mov_i64_concrete(temp_tcgv_i64(temp_expr(tcgv_i64_temp(in))),
+                             tcg_constant_i64(value));
+    tcg_gen_neg_i64(out, in);
+    tcg_optimize(tcg_ctx);
+
+    QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+        calls += op->opc == INDEX_op_call;
+    }
+    return calls;
+}
+
+static void fold_sym_call_test(void)
+{
+    /* A NULL input expression makes the helper call redundant... */
+    g_assert_cmpint(optimized_neg_calls(0), ==, 0);
+
+    /* ...but not a constant that copy propagation put in its place. */
+    g_assert_cmpint(optimized_neg_calls(0x1234), ==, 1);
+}
+
+static uint64_t fused_value(const uint64_t *vals, TCGArg arg)
+{
+    TCGTemp *ts = arg_temp(arg);
+
+    return ts->kind == TEMP_CONST ? ts->val : vals[temp_idx(ts)];
+}
+
+/*
+ * Execute the ops of a fused straight-line TB on @env, with the values of the
+ * temps in @vals. Returns the number of expression programs that ran.
+ */
+static int run_fused_ops(CPUArchState *env, uint64_t *vals)
+{
+    TCGOp *op;
+    int programs = 0;
+
+    QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+        TCGArg *args = op->args;
+
+        switch (op->opc) {
+        case INDEX_op_mov_i64:
+            vals[temp_idx(arg_temp(args[0]))] = fused_value(vals, args[1]);
+            break;
+        case INDEX_op_add_i32:
+            vals[temp_idx(arg_temp(args[0]))] = (uint32_t)(
+                fused_value(vals, args[1]) + fused_value(vals, args[2]));
+            break;
+        case INDEX_op_add_i64:
+            vals[temp_idx(arg_temp(args[0]))] =
+                fused_value(vals, args[1]) + fused_value(vals, args[2]);
+            break;
+        case INDEX_op_xor_i64:
+            vals[temp_idx(arg_temp(args[0]))] =
+                fused_value(vals, args[1]) ^ fused_value(vals, args[2]);
+            break;
+        case INDEX_op_st_i32:
+            stl_he_p((void *)env + args[2], fused_value(vals, args[0]));
+            break;
+        case INDEX_op_st_i64:
+            stq_he_p((void *)env + args[2], fused_value(vals, args[0]));
+            break;
+        case INDEX_op_ld_i64:
+            vals[temp_idx(arg_temp(args[0]))] = ldq_he_p((void *)env + args[2]);
+            break;
+        case INDEX_op_call:
+            g_assert_true(tcg_call_info(op)->func ==
+                          (void *)helper_sym_run_program);
+            helper_sym_run_program(env,
+                                   (const void *)(uintptr_t)fused_value(
+                                       vals, args[1]));
+            programs++;
+            break;
+        default:
+            g_assert_not_reached();
+        }
+    }
+    return programs;
+}
+
+static void set_fused_input(uint64_t *vals, TCGTemp *ts, uint64_t val,
+                            void *expr)
+{
+    vals[temp_idx(ts)] = val;
+    vals[temp_idx(temp_expr(ts))] = (uintptr_t)expr;
+}
+
+static void *fused_expression(const uint64_t *vals, TCGTemp *ts)
+{
+    return (void *)(uintptr_t)vals[temp_idx(temp_expr(ts))];
+}
+
+static void assert_same_expression(void *expr, void *expected)
+{
+    if (expected == NULL) {
+        g_assert_null(expr);
+    } else {
+        g_assert_nonnull(expr);
+        g_assert_false(_sym_feasible(_sym_build_not_equal(expr, expected)));
+    }
+}
+
+/*
+ * Fuse a run of helper calls and check that the program computes the same
+ * expressions as the helpers themselves, given the input expressions @e0 and
+ * @e1 (64 bits) and @ex (32 bits).
+ */
+static void check_fused_program(void *e0, void *e1, void *ex)
+{
+    X86CPU *arch = g_new0(X86CPU, 1);
+    TCGv_i64 in0, in1, sum, copy, mix;
+    TCGv_i32 x, y, sum32;
+    uint64_t *vals;
+    void *expected_sum;
+
+    tcg_setup();
+    tcg_ctx->sym_fast_path = false;
+    tcg_func_start(tcg_ctx);
+
+    in0 = tcg_temp_new_i64();
+    in1 = tcg_temp_new_i64();
+    sum = tcg_temp_new_i64();
+    copy = tcg_temp_new_i64();
+    mix = tcg_temp_new_i64();
+    x = tcg_temp_new_i32();
+    y = tcg_temp_new_i32();
+    sum32 = tcg_temp_new_i32();
+
+    tcg_gen_add_i64(sum, in0, in1);
+    tcg_gen_mov_i64(copy, sum);
+    tcg_gen_xor_i64(mix, copy, in0);
+    tcg_gen_add_i32(sum32, x, y);
+    tcg_sym_fuse(tcg_ctx);
+
+    vals = g_new0(uint64_t, tcg_ctx->nb_temps);
+    set_fused_input(vals, tcgv_i64_temp(in0), 0x1234, e0);
+    set_fused_input(vals, tcgv_i64_temp(in1), 0x10, e1);
+    set_fused_input(vals, tcgv_i32_temp(x), 5, ex);
+    set_fused_input(vals, tcgv_i32_temp(y), 7, NULL);
+    g_assert_cmpint(run_fused_ops(&arch->env, vals), ==, 1);
+
+    expected_sum = helper_sym_add_i64(0x1234, e0, 0x10, e1);
+    assert_same_expression(fused_expression(vals, tcgv_i64_temp(sum)),
+                           expected_sum);
+    assert_same_expression(fused_expression(vals, tcgv_i64_temp(copy)),
+                           expected_sum);
+    assert_same_expression(fused_expression(vals, tcgv_i64_temp(mix)),
+                           helper_sym_xor_i64(0x1244, expected_sum,
+                                              0x1234, e0));
+    assert_same_expression(fused_expression(vals, tcgv_i32_temp(sum32)),
+                           helper_sym_add_i32(5, ex, 7, NULL));
+
+    g_free(vals);
+    g_free(arch);
+}
+
+static void fused_program_test(void)
+{
+    /* Concrete inputs take the shortcut through the program... */
+    check_fused_program(NULL, NULL, NULL);
+
+    /* ...symbolic ones run each helper through its typed entry point. */
+    check_fused_program(_sym_build_integer(0x1234, 64), NULL,
+                        _sym_build_integer(5, 32));
+    check_fused_program(NULL, _sym_build_integer(0x10, 64), NULL);
+}
+
+/* Generate host code for the ops emitted so far, as a TB of one insn. */
+static void gen_test_code(void)
+{
+    TranslationBlock *tb = tcg_tb_alloc(tcg_ctx);
+
+    tcg_gen_exit_tb(NULL, 0);
+    tb->tc.ptr = tcg_splitwx_to_rx(tcg_ctx->code_gen_ptr);
+    tb->cflags = 1;
+    tb->icount = 1;
+    tcg_ctx->gen_tb = tb;
+    g_assert_cmpint(tcg_gen_code(tcg_ctx, tb, 0), >, 0);
+    tcg_ctx->gen_tb = NULL;
+}
+
+/*
+ * Whether liveness keeps the expression of a setcond under the fast path,
+ * when the result is overwritten after the fast path and possibly (if
+ * @read_first) stored before that.
+ */
+static bool setcond_expression_kept(bool read_first)
+{
+    TCGv_i64 a, b, ret;
+    TCGOp *op;
+    bool kept = false;
+
+    fast_path_start();
+    tcg_gen_insn_start(0, 0);
+    a = tcg_temp_new_i64();
+    b = tcg_temp_new_i64();
+    ret = tcg_temp_new_i64();
+
+    tcg_gen_setcond_i64(TCG_COND_EQ, ret, a, b);
+    if (read_first) {
+        tcg_gen_st_i64(ret, tcg_env, offsetof(CPUX86State, regs[R_EAX]));
+    }
+    tcg_gen_movi_i64(ret, 1);
+    gen_test_code();
+
+    QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+        kept |= op->opc == INDEX_op_call &&
+                tcg_call_info(op)->func == (void *)helper_sym_setcond_i64;
+    }
+    return kept;
+}
+
+static void dead_fast_path_expression_test(void)
+{
+    /* The fast path leaves the dead output in TS_DEAD | TS_MEM state... */
+    g_assert_false(setcond_expression_kept(false));
+
+    /* ...but a read in the next basic block keeps it alive. */
+    g_assert_true(setcond_expression_kept(true));
+}
+
+/* Whether the TB variant chosen for @cpu is the instrumented one. */
+static bool instrumented_variant(CPUState *cpu)
+{
+    return !(sym_select_variant(cpu, 1) & CF_SYM_CONCRETE);
+}
+
+static void dual_tb_variant_test(void)
+{
+    X86CPU *arch = g_new0(X86CPU, 1);
+    CPUState *cpu = &arch->parent_obj;
+    uint8_t *reg = (uint8_t *)&arch->env.regs[R_EAX];
+    int i;
+
+    tcg_setup();
+    current_cpu = cpu;
+
+    sym_dual_tb = false;
+    g_assert_true(instrumented_variant(cpu));
+    sym_dual_tb = true;
+    g_assert_false(instrumented_variant(cpu));
+
+    /* Symbolic register expressions need the instrumented variant... */
+    arch->env_exprs[0] = _sym_build_integer(1, 64);
+    g_assert_true(instrumented_variant(cpu));
+    arch->env_exprs[0] = NULL;
+
+    /* ...and so does a restarted instruction, once. */
+    cpu->sym_force_instrumented = true;
+    g_assert_true(instrumented_variant(cpu));
+    g_assert_false(instrumented_variant(cpu));
+
+    /* Symbolic bytes in the CPU state are only rechecked now and then... */
+    helper_sym_store_host(_sym_build_integer(0x42, 8), reg, 1, 1);
+    for (i = 0; i < 4096; i++) {
+        g_assert_true(instrumented_variant(cpu));
+    }
+
+    /* ...until they have been overwritten with concrete data. */
+    helper_sym_store_host(NULL, reg, 1, 1);
+    for (i = 0; i < 4096 && instrumented_variant(cpu); i++) {
+        /* Wait for the next check. */
+    }
+    g_assert_cmpint(i, <, 4096);
+    g_assert_false(cpu->sym_env_dirty);
+
+    sym_dual_tb = false;
+    current_cpu = NULL;
+    g_free(cpu->sym_env_words);
+    g_free(arch);
+}
+
 int main(int argc, char* argv[])
 {
     g_test_init(&argc, &argv, NULL);
     fclose(stdin);              /* for the Qsym backend */
+    /* Let the tests trigger real collections (see constant_cache_test). */
+    g_setenv("SYMCC_GC_THRESHOLD", G_STRINGIFY(SYM_TEST_GC_THRESHOLD), TRUE);
     _sym_initialize();
 
 #define REGISTER_TEST(name) g_test_add_func("/sym/" #name, name##_test)
@@ -404,6 +897,17 @@ int main(int argc, char* argv[])
     REGISTER_TEST(load_store_guest);
     REGISTER_TEST(load_store_host);
     REGISTER_TEST(muluh);
+    REGISTER_TEST(fast_path_alias);
+    REGISTER_TEST(fast_path_alias_vec);
+    REGISTER_TEST(dual_tb_variant);
+    REGISTER_TEST(fold_sym_call);
+    REGISTER_TEST(fused_program);
+    REGISTER_TEST(dead_fast_path_expression);
+    REGISTER_TEST(constant_cache);
+    REGISTER_TEST(vector_lanes);
+    REGISTER_TEST(page_map);
+    REGISTER_TEST(branch_budget);
+    REGISTER_TEST(query_counter);
 #undef REGISTER_TEST
 
     return g_test_run();